@@ -0,0 +1,182 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <bvh/capture.hpp>
+#include <bvh/collision_object.hpp>
+#include <bvh/collision_world.hpp>
+#include <bvh/kdop.hpp>
+
+#include <Kokkos_Core.hpp>
+#include <vt/transport.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// Replays the inputs captured with collision_world::start_capture, one capture file per rank.
+// The narrowphase is replaced by an element-vs-element bounds check, so the timings cover the library
+// and not the application's contact detection.
+//
+// usage: mpirun -np <ranks of the capture> replay_capture <capture prefix>
+
+namespace
+{
+  struct replay_contact
+  {
+    std::size_t a;
+    std::size_t b;
+  };
+
+  bvh::narrowphase_result_pair stand_in_narrowphase( const bvh::broadphase_collision< bvh::captured_entity > &_a,
+                                                     const bvh::broadphase_collision< bvh::captured_entity > &_b )
+  {
+    bvh::narrowphase_result_pair res;
+    res.a = bvh::narrowphase_result( sizeof( replay_contact ) );
+    res.b = bvh::narrowphase_result( sizeof( replay_contact ) );
+    auto &resa = static_cast< bvh::typed_narrowphase_result< replay_contact > & >( res.a );
+
+    auto check = [&]( const bvh::captured_entity &_ea, const bvh::captured_entity &_eb ) {
+      if ( overlap( _ea.kdop(), _eb.kdop() ) )
+        resa.emplace_back( replay_contact{ _ea.global_id(), _eb.global_id() } );
+    };
+
+    if ( !_a.element_candidates.empty() )
+    {
+      for ( auto &&[i, j] : _a.element_candidates )
+        check( _a.elements[i], _b.elements[j] );
+    } else {
+      for ( auto &&ea : _a.elements )
+        for ( auto &&eb : _b.elements )
+          check( ea, eb );
+    }
+
+    return res;
+  }
+
+  int replay( const char *_prefix )
+  {
+    const auto rank = static_cast< std::uint32_t >( ::vt::theContext()->getNode() );
+    const auto num_ranks = static_cast< std::uint32_t >( ::vt::theContext()->getNumNodes() );
+
+    // Read everything up front so file IO isn't part of the timings
+    bvh::capture_reader reader( bvh::capture_file_path( _prefix, rank ) );
+    if ( reader.header().num_ranks != num_ranks )
+    {
+      std::fprintf( stderr, "capture was taken on %u ranks, replaying on %u\n", reader.header().num_ranks, num_ranks );
+      return 1;
+    }
+
+    std::vector< bvh::capture_event > events;
+    std::size_t num_objects = 0;
+    bvh::capture_event ev;
+    while ( reader.next( ev ) )
+    {
+      num_objects = std::max( num_objects, std::max( ev.object, ev.other ) + 1 );
+      events.push_back( std::move( ev ) );
+      ev = bvh::capture_event{};
+    }
+
+    bvh::collision_world world( reader.header().overdecomposition );
+    world.set_narrowphase_functor< bvh::captured_entity >( stand_in_narrowphase );
+
+    // Objects are created collectively; every rank captured the same collective calls, so the counts agree
+    std::vector< bvh::collision_object * > objects;
+    for ( std::size_t i = 0; i < num_objects; ++i )
+      objects.push_back( &world.create_collision_object() );
+
+    std::vector< bvh::view< bvh::captured_entity * > > entities( num_objects );
+    std::size_t iteration = 0;
+    auto start = std::chrono::steady_clock::now();
+    for ( auto &&e : events )
+    {
+      switch ( e.kind )
+      {
+        case bvh::capture_record::begin_iteration:
+          start = std::chrono::steady_clock::now();
+          world.start_iteration();
+          break;
+        case bvh::capture_record::end_iteration:
+        {
+          world.finish_iteration();
+          const std::chrono::duration< double, std::milli > elapsed = std::chrono::steady_clock::now() - start;
+          if ( rank == 0 )
+            std::printf( "iteration %zu: %.3f ms\n", iteration, elapsed.count() );
+          ++iteration;
+          break;
+        }
+        case bvh::capture_record::set_entity_data:
+        {
+          // The view has to outlive the narrowphase, so it is kept per object
+          auto &view = entities[e.object];
+          Kokkos::resize( Kokkos::WithoutInitializing, view, e.entities.size() );
+          for ( std::size_t i = 0; i < e.entities.size(); ++i )
+            view( i ) = e.entities[i];
+          objects[e.object]->set_entity_data( view, e.algorithm );
+          break;
+        }
+        case bvh::capture_record::init_broadphase:
+          objects[e.object]->init_broadphase();
+          break;
+        case bvh::capture_record::broadphase:
+          objects[e.object]->broadphase( *objects[e.other], e.orientation );
+          break;
+      }
+    }
+
+    return 0;
+  }
+}
+
+int
+main( int _argc, char **_argv )
+{
+  if ( _argc < 2 )
+  {
+    std::fprintf( stderr, "usage: %s <capture prefix>\n", _argv[0] );
+    return 1;
+  }
+
+  Kokkos::initialize( _argc, _argv );
+  int ret = 0;
+
+  {
+    ::vt::initialize( _argc, _argv );
+
+    ::vt::runInEpochCollective( "replay_capture", [&ret, _argv]() { ret = replay( _argv[1] ); } );
+
+    ::vt::finalize();
+  }
+
+  Kokkos::finalize();
+  return ret;
+}
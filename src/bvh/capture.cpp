@@ -0,0 +1,183 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "capture.hpp"
+#include "exceptions/capture_file_exception.hpp"
+
+namespace bvh
+{
+  std::string
+  capture_file_path( const std::string &_prefix, std::uint32_t _rank )
+  {
+    return _prefix + "." + std::to_string( _rank ) + ".bin";
+  }
+
+  capture_writer::capture_writer( const std::string &_path, std::uint32_t _rank, std::uint32_t _num_ranks,
+                                  std::size_t _overdecomposition )
+    : m_path( _path ),
+      m_out( _path, std::ios::binary | std::ios::trunc )
+  {
+    if ( !m_out )
+      throw capture_file_exception( m_path, "could not open the file for writing" );
+
+    capture_header header;
+    header.magic = capture_magic;
+    header.version = capture_version;
+    header.rank = _rank;
+    header.num_ranks = _num_ranks;
+    header.snapshot_size = sizeof( entity_snapshot );
+    header.overdecomposition = _overdecomposition;
+    write( header );
+  }
+
+  void
+  capture_writer::begin_iteration()
+  {
+    write( capture_record::begin_iteration );
+  }
+
+  void
+  capture_writer::end_iteration()
+  {
+    write( capture_record::end_iteration );
+    // Flush once per iteration so a crashing run still leaves the completed iterations behind
+    m_out.flush();
+  }
+
+  void
+  capture_writer::set_entity_data( std::size_t _object, split_algorithm _algorithm, std::size_t _element_size,
+                                   span< const entity_snapshot > _snapshots )
+  {
+    write( capture_record::set_entity_data );
+    write( static_cast< std::uint64_t >( _object ) );
+    write( static_cast< std::uint32_t >( _algorithm ) );
+    write( static_cast< std::uint64_t >( _element_size ) );
+    write( static_cast< std::uint64_t >( _snapshots.size() ) );
+    m_out.write( reinterpret_cast< const char * >( _snapshots.data() ),
+                 static_cast< std::streamsize >( _snapshots.size() * sizeof( entity_snapshot ) ) );
+  }
+
+  void
+  capture_writer::init_broadphase( std::size_t _object )
+  {
+    write( capture_record::init_broadphase );
+    write( static_cast< std::uint64_t >( _object ) );
+  }
+
+  void
+  capture_writer::broadphase( std::size_t _object, std::size_t _other, broadphase_orientation _orientation )
+  {
+    write( capture_record::broadphase );
+    write( static_cast< std::uint64_t >( _object ) );
+    write( static_cast< std::uint64_t >( _other ) );
+    write( static_cast< std::uint32_t >( _orientation ) );
+  }
+
+  capture_reader::capture_reader( const std::string &_path )
+    : m_path( _path ),
+      m_in( _path, std::ios::binary | std::ios::ate )
+  {
+    if ( !m_in )
+      throw capture_file_exception( m_path, "could not open the file" );
+    m_size = static_cast< std::uint64_t >( m_in.tellg() );
+    m_in.seekg( 0 );
+
+    read( m_header );
+    if ( m_header.magic != capture_magic )
+      throw capture_file_exception( m_path, "not a capture file" );
+    if ( m_header.version != capture_version )
+      throw capture_file_exception( m_path, "unsupported version" );
+    if ( m_header.snapshot_size != sizeof( entity_snapshot ) )
+      throw capture_file_exception( m_path, "captured with a different snapshot layout" );
+  }
+
+  bool
+  capture_reader::next( capture_event &_event )
+  {
+    capture_record kind;
+    m_in.read( reinterpret_cast< char * >( &kind ), sizeof( kind ) );
+    if ( m_in.gcount() == 0 && m_in.eof() )
+      return false;
+    if ( !m_in )
+      truncated();
+
+    _event.kind = kind;
+    std::uint64_t object = 0;
+    std::uint64_t other = 0;
+    std::uint32_t enum_value = 0;
+    std::uint64_t element_size = 0;
+    std::uint64_t count = 0;
+    switch ( kind )
+    {
+      case capture_record::begin_iteration:
+      case capture_record::end_iteration:
+        break;
+      case capture_record::set_entity_data:
+        read( object );
+        read( enum_value );
+        read( element_size );
+        read( count );
+        _event.object = object;
+        _event.algorithm = static_cast< split_algorithm >( enum_value );
+        _event.element_size = element_size;
+        // Check the count before allocating, a corrupt count must not turn into a huge allocation
+        if ( count > ( m_size - static_cast< std::uint64_t >( m_in.tellg() ) ) / sizeof( entity_snapshot ) )
+          truncated();
+        _event.entities.resize( count );
+        for ( auto &&e : _event.entities )
+          read( e.snapshot );
+        break;
+      case capture_record::init_broadphase:
+        read( object );
+        _event.object = object;
+        break;
+      case capture_record::broadphase:
+        read( object );
+        read( other );
+        read( enum_value );
+        _event.object = object;
+        _event.other = other;
+        _event.orientation = static_cast< broadphase_orientation >( enum_value );
+        break;
+      default:
+        throw capture_file_exception( m_path, "unknown record" );
+    }
+
+    return true;
+  }
+
+  void
+  capture_reader::truncated() const
+  {
+    throw capture_file_exception( m_path, "truncated" );
+  }
+}
@@ -0,0 +1,173 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef INC_BVH_CAPTURE_HPP
+#define INC_BVH_CAPTURE_HPP
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "snapshot.hpp"
+#include "types.hpp"
+#include "util/span.hpp"
+
+namespace bvh
+{
+  /// \brief Kind of a record in a capture file, see \ref capture_writer
+  enum class capture_record : std::uint32_t
+  {
+    begin_iteration,
+    end_iteration,
+    set_entity_data,
+    init_broadphase,
+    broadphase
+  };
+
+  /// \brief Header at the start of every per-rank capture file
+  struct capture_header
+  {
+    std::array< char, 8 > magic;
+    std::uint32_t version;
+    std::uint32_t rank;
+    std::uint32_t num_ranks;
+    std::uint32_t snapshot_size;  ///< `sizeof( entity_snapshot )` of the capturing build
+    std::uint64_t overdecomposition;
+  };
+
+  inline constexpr std::array< char, 8 > capture_magic{ 'D', 'B', 'V', 'H', 'C', 'A', 'P', 'T' };
+  inline constexpr std::uint32_t capture_version = 1;
+
+  /// \brief The capture file of a rank, `<prefix>.<rank>.bin`
+  std::string capture_file_path( const std::string &_prefix, std::uint32_t _rank );
+
+  /// \brief The element type a replay hands to `set_entity_data` in place of the captured application element
+  ///
+  /// It carries the bounds, centroid and global id the library saw, which is all the splitting, tree building
+  /// and broadphase depend on.
+  struct captured_entity
+  {
+    entity_snapshot snapshot;
+
+    KOKKOS_INLINE_FUNCTION bphase_kdop kdop() const noexcept { return snapshot.kdop(); }
+    KOKKOS_INLINE_FUNCTION entity_snapshot::centroid_type centroid() const noexcept { return snapshot.centroid(); }
+    KOKKOS_INLINE_FUNCTION std::size_t global_id() const noexcept { return snapshot.global_id(); }
+  };
+
+  /**
+   * Writes the calls a rank makes into the library to a binary file, so they can be replayed offline without
+   * the application, see `collision_world::start_capture`.
+   *
+   * Each record starts with its \ref capture_record kind. Elements are written as the snapshots of
+   * `set_entity_data` in their original order.
+   */
+  class capture_writer
+  {
+  public:
+
+    capture_writer( const std::string &_path, std::uint32_t _rank, std::uint32_t _num_ranks,
+                    std::size_t _overdecomposition );
+
+    void begin_iteration();
+    void end_iteration();
+
+    /// \param[in] _object        id of the collision object
+    /// \param[in] _algorithm     the split algorithm passed to `set_entity_data`
+    /// \param[in] _element_size  size of the application's element type
+    /// \param[in] _snapshots     the snapshots of the elements, in their original order
+    void set_entity_data( std::size_t _object, split_algorithm _algorithm, std::size_t _element_size,
+                          span< const entity_snapshot > _snapshots );
+    void init_broadphase( std::size_t _object );
+    void broadphase( std::size_t _object, std::size_t _other, broadphase_orientation _orientation );
+
+  private:
+
+    template< typename T >
+    void write( const T &_val )
+    {
+      m_out.write( reinterpret_cast< const char * >( &_val ), sizeof( T ) );
+    }
+
+    std::string m_path;
+    std::ofstream m_out;
+  };
+
+  /// \brief A record read back from a capture file
+  struct capture_event
+  {
+    capture_record kind = capture_record::begin_iteration;
+    std::size_t object = 0;
+    std::size_t other = 0;  ///< The other object of a `broadphase` record
+    split_algorithm algorithm = split_algorithm::geom_axis;
+    broadphase_orientation orientation = broadphase_orientation::this_patches;
+    std::size_t element_size = 0;  ///< Size of the application's element type of a `set_entity_data` record
+    std::vector< captured_entity > entities;
+  };
+
+  /// \brief Reads a file written by \ref capture_writer
+  class capture_reader
+  {
+  public:
+
+    /// \throws capture_file_exception if the file can't be read or was written by an incompatible build
+    explicit capture_reader( const std::string &_path );
+
+    const capture_header &header() const noexcept { return m_header; }
+
+    /// \brief Read the next record
+    ///
+    /// \param[out] _event  the record
+    /// \return             false at the end of the file
+    /// \throws capture_file_exception if the file is truncated or corrupt
+    bool next( capture_event &_event );
+
+  private:
+
+    template< typename T >
+    void read( T &_val )
+    {
+      m_in.read( reinterpret_cast< char * >( &_val ), sizeof( T ) );
+      if ( !m_in )
+        truncated();
+    }
+
+    [[noreturn]] void truncated() const;
+
+    std::string m_path;
+    std::ifstream m_in;
+    std::uint64_t m_size = 0;  ///< Size of the file in bytes
+    capture_header m_header;
+  };
+}
+
+#endif  // INC_BVH_CAPTURE_HPP
@@ -37,7 +37,18 @@
 #include "collision_object/top_down.hpp"
 #include "collision_object/broadphase.hpp"
 #include "collision_object/narrowphase.hpp"
+#include "collision_object/global_morton.hpp"
+#include "collision_object/in_process.hpp"
+#include "collision_object/overdecomposition.hpp"
+#include "exceptions/state_file_exception.hpp"
+#include "split/morton_splitters.hpp"
+#include "split/rebalance.hpp"
+#include "tree_build.hpp"
 #include <unordered_map>
+#include <fstream>
+#include <algorithm>
+#include <array>
+#include <cstdint>
 
 namespace bvh
 {
@@ -60,10 +71,154 @@ namespace bvh
       // Guard the memcpy because it's UB even if size is zero if the pointers are invalid
       if ( _msg->data_size > 0 )
         std::memcpy( _coll->bytes.data(), _msg->user_data(), _msg->data_size );
+      _coll->tree_bytes.assign( _msg->tree_data(), _msg->tree_data() + _msg->tree_size );
       _coll->origin_node = _msg->origin_node;
+      _coll->set_generation( _msg->generation );
+    }
+
+    /// Estimated narrowphase work of each local patch last step, empty if there is no history for the
+    /// current elements
+    std::vector< double > last_step_patch_loads( const collision_object::impl &_impl )
+    {
+      const std::size_t n = _impl.split_indices_h.extent( 0 );
+      const std::size_t od_factor = _impl.overdecomposition;
+
+      if ( _impl.last_element_patch.size() != n || _impl.patch_pair_counts.size() != od_factor )
+        return {};
+
+      std::vector< std::size_t > last_sizes( od_factor, 0 );
+      for ( auto &&p : _impl.last_element_patch )
+        ++last_sizes[p];
+      std::vector< double > loads( od_factor );
+      for ( std::size_t i = 0; i < od_factor; ++i )
+        loads[i] = static_cast< double >( last_sizes[i] ) * static_cast< double >( _impl.patch_pair_counts[i] );
+
+      return loads;
+    }
+
+    /// Re-split the local elements weighted by the narrowphase pairs their patch took part in last step,
+    /// so that hot patches are divided among several patches and cold ones are merged
+    ///
+    /// \return whether the splits changed
+    bool rebalance_hot_patches( collision_object::impl &_impl, spdlog::logger &_logger )
+    {
+      const std::size_t n = _impl.split_indices_h.extent( 0 );
 
-      // Reset cache destinations
-      _coll->ghost_destinations.clear();
+      const auto loads = last_step_patch_loads( _impl );
+      if ( loads.empty() )
+        return false;
+
+      const double imbalance = max_load_imbalance( loads );
+      if ( imbalance <= _impl.patch_rebalance_threshold )
+        return false;
+
+      std::vector< double > weights( n );
+      for ( std::size_t j = 0; j < n; ++j )
+        weights[j] = 1.0 + static_cast< double >( _impl.patch_pair_counts[_impl.last_element_patch[_impl.split_indices_h( j )]] );
+
+      auto splits = weighted_splits( weights, _impl.num_splits );
+      SPDLOG_LOGGER_DEBUG( &_logger, "obj={} patch load imbalance {} exceeds {}, rebalancing {} elements", _impl.collision_idx,
+                                     imbalance, _impl.patch_rebalance_threshold, n );
+      for ( std::size_t i = 0; i < _impl.num_splits; ++i )
+        _impl.splits_h( i ) = splits[i];
+      Kokkos::deep_copy( _impl.splits, _impl.splits_h );
+
+      return true;
+    }
+
+    /// Sum of the extent lengths along every axis, used to measure how much bounds grew
+    double extent_measure( const bphase_kdop &_kdop )
+    {
+      double ret = 0.0;
+      for ( int a = 0; a < bphase_kdop::num_axis; ++a )
+        ret += static_cast< double >( _kdop.extents[a].length() );
+      return ret;
+    }
+
+    /// The part of a collision object's state written by `save_state`. The snapshots and the broadphase tree are
+    /// not saved: both depend on the element positions, so the next `set_entity_data` and `init_broadphase` have to
+    /// recompute them anyway
+    struct saved_state
+    {
+      std::size_t overdecomposition = 0;
+      std::vector< std::size_t > split_indices;
+      std::vector< std::size_t > splits;
+      std::vector< kdop_type > reference_patch_bounds;
+      std::vector< std::size_t > last_element_patch;
+      std::vector< std::size_t > patch_pair_counts;
+
+      template< typename Serializer >
+      void serialize( Serializer &_s )
+      {
+        _s | overdecomposition | split_indices | splits | reference_patch_bounds | last_element_patch
+          | patch_pair_counts;
+      }
+    };
+
+    /// Header in front of the serialized `saved_state`, so that a truncated or corrupt file is detected before
+    /// the payload is deserialized
+    struct saved_state_header
+    {
+      std::array< char, 8 > magic;
+      std::uint32_t version;
+      std::uint64_t size;      ///< bytes of the serialized state following the header
+      std::uint64_t checksum;  ///< `state_checksum` of those bytes
+    };
+
+    inline constexpr std::array< char, 8 > saved_state_magic{ 'D', 'B', 'V', 'H', 'S', 'T', 'A', 'T' };
+    inline constexpr std::uint32_t saved_state_version = 2;
+
+    /// FNV-1a hash of the serialized state
+    std::uint64_t state_checksum( const char *_data, std::size_t _size )
+    {
+      std::uint64_t h = 14695981039346656037ull;
+      for ( std::size_t i = 0; i < _size; ++i )
+      {
+        h ^= static_cast< unsigned char >( _data[i] );
+        h *= 1099511628211ull;
+      }
+      return h;
+    }
+
+    /// \return why `_state` can't be restored into an object with `_od` patches, or nullptr if it can
+    const char *invalid_state_reason( const saved_state &_state, std::size_t _od )
+    {
+      const std::size_t n = _state.split_indices.size();
+      if ( _state.overdecomposition != _od )
+        return "saved with a different overdecomposition factor";
+      if ( _state.splits.size() + 1 != _od )
+        return "number of splits does not match the overdecomposition factor";
+      if ( _state.reference_patch_bounds.size() != _od || _state.patch_pair_counts.size() != _od )
+        return "per-patch data does not match the overdecomposition factor";
+      if ( !_state.last_element_patch.empty() && _state.last_element_patch.size() != n )
+        return "number of element patches and split indices differ";
+
+      std::vector< bool > seen( n, false );
+      for ( auto &&i : _state.split_indices )
+      {
+        if ( i >= n || seen[i] )
+          return "split indices are not a permutation";
+        seen[i] = true;
+      }
+      for ( std::size_t i = 0; i < _state.splits.size(); ++i )
+        if ( _state.splits[i] > n || ( i > 0 && _state.splits[i] < _state.splits[i - 1] ) )
+          return "splits out of order or out of range";
+      for ( auto &&p : _state.last_element_patch )
+        if ( p >= _od )
+          return "element patch out of range";
+
+      return nullptr;
+    }
+
+    /// \brief Run a collective step over both objects of a pair, which may be the same multi-body object
+    template< typename F >
+    void pair_step( const std::string &_label, collision_object::impl &_this, collision_object::impl &_other, F &&_fun )
+    {
+      if ( &_this == &_other )
+        _this.chainset.nextStepCollective( _label, std::forward< F >( _fun ) );
+      else
+        ::vt::messaging::CollectionChainSet< vt_index >::mergeStepCollective( _label, _this.chainset, _other.chainset,
+                                                                              std::forward< F >( _fun ) );
     }
   } // namespace details
 
@@ -71,15 +226,15 @@ namespace bvh
     : m_impl{ std::make_unique< impl >( _world, _idx ) }
   {
     bvh_splitting_geom_axis_ = ::vt::theTrace()->registerUserEventColl( "bvh_splitting_geom_axis_" );
-    m_impl->logger->trace( "obj={} registered user tracing event bvh_splitting_geom_axis_", m_impl->collision_idx );
+    SPDLOG_LOGGER_TRACE( m_impl->logger, "obj={} registered user tracing event bvh_splitting_geom_axis_", m_impl->collision_idx );
     bvh_splitting_ml_ = ::vt::theTrace()->registerUserEventColl( "bvh_splitting_ml_" );
-    m_impl->logger->trace( "obj={} registered user tracing event bvh_splitting_ml_", m_impl->collision_idx );
+    SPDLOG_LOGGER_TRACE( m_impl->logger, "obj={} registered user tracing event bvh_splitting_ml_", m_impl->collision_idx );
     bvh_set_entity_data_impl_ = ::vt::theTrace()->registerUserEventColl( "bvh_set_entity_data_impl_" );
-    m_impl->logger->trace( "obj={} registered user tracing event bvh_set_entity_data_impl_", m_impl->collision_idx );
+    SPDLOG_LOGGER_TRACE( m_impl->logger, "obj={} registered user tracing event bvh_set_entity_data_impl_", m_impl->collision_idx );
     bvh_clustering_ = ::vt::theTrace()->registerUserEventColl( "bvh_clustering_" );
-    m_impl->logger->trace( "obj={} registered user tracing event bvh_clustering_", m_impl->collision_idx );
+    SPDLOG_LOGGER_TRACE( m_impl->logger, "obj={} registered user tracing event bvh_clustering_", m_impl->collision_idx );
     bvh_build_trees_ = ::vt::theTrace()->registerUserEventColl( "bvh_build_trees_" );
-    m_impl->logger->trace( "obj={} registered user tracing event bvh_build_trees_", m_impl->collision_idx );
+    SPDLOG_LOGGER_TRACE( m_impl->logger, "obj={} registered user tracing event bvh_build_trees_", m_impl->collision_idx );
 
     m_impl->overdecomposition = _overdecomposition;
 
@@ -88,29 +243,54 @@ namespace bvh
       m_impl->chainset.addIndex( vt_index{ i } );
     }
 
-    m_impl->logger->trace( "obj={} adding {} local indices", m_impl->collision_idx, m_impl->overdecomposition );
-
-    // Initialize objgroup for per-node data
-    ::vt::runInEpochCollective( "collision_object.make_objgroup", [&](){
-      m_impl->objgroup = ::vt::theObjGroup()->makeCollective<collision_object_holder>( fmt::format( "collision_object {}", _idx ) );
-      m_impl->objgroup.get()->self = this;
-
-      m_impl->logger->debug( "obj={} objgroup make_collective {:x}", m_impl->collision_idx, m_impl->objgroup.getProxy() );
-    });
+    SPDLOG_LOGGER_TRACE( m_impl->logger, "obj={} adding {} local indices", m_impl->collision_idx, m_impl->overdecomposition );
 
     m_impl->local_patches.resize( m_impl->overdecomposition );
 
     m_impl->logger->info( "initialized collision object {}", m_impl->collision_idx );
   }
 
+  void collision_object::make_objgroup()
+  {
+    m_impl->objgroup = ::vt::theObjGroup()->makeCollective<collision_object_holder>( fmt::format( "collision_object {}", m_impl->collision_idx ) );
+    m_impl->objgroup.get()->self = this;
+
+    SPDLOG_LOGGER_DEBUG( m_impl->logger, "obj={} objgroup make_collective {:x}", m_impl->collision_idx, m_impl->objgroup.getProxy() );
+  }
+
+  void collision_object::make_collections( std::vector< ::vt::EpochType > &_pending ) const
+  {
+    auto coll_size = vt_index{ static_cast< std::size_t >( m_impl->overdecomposition * ::vt::theContext()->getNumNodes() ) };
+
+    logger().info( "constructing broadphase patch collection with {} elements", coll_size );
+    auto [broadphase_patch_epoch, broadphase_patch_proxy]
+      = ::vt::makeCollection< broadphase_patch_collection_type >().bounds( coll_size ).bulkInsert().deferWithEpoch();
+    m_impl->broadphase_patch_collection_proxy = broadphase_patch_proxy;
+    _pending.push_back( broadphase_patch_epoch );
+
+    logger().info( "constructing narrophase patch collection with {} elements", coll_size );
+    auto [narrowphase_patch_epoch, narrowphase_patch_proxy] = ::vt::makeCollection< narrowphase_patch_collection_type >()
+      .elementConstructor( [this]( narrowphase_patch_collection_type::IndexType ){ return std::make_unique< narrowphase_patch_collection_type >( m_impl->objgroup ); } )
+      .bounds( coll_size ).bulkInsert().deferWithEpoch();
+    m_impl->narrowphase_patch_collection_proxy = narrowphase_patch_proxy;
+    _pending.push_back( narrowphase_patch_epoch );
+
+    logger().info( "constructing narrowphase collection with dynamic membership" );
+    auto [narrowphase_epoch, narrowphase_proxy]
+      = ::vt::makeCollection< narrowphase_collection_type >().dynamicMembership( true ).deferWithEpoch();
+    m_impl->narrowphase_collection_proxy = narrowphase_proxy;
+    _pending.push_back( narrowphase_epoch );
+  }
+
   collision_object::~collision_object() = default;
 
-  void collision_object::set_entity_data_impl( const void *_data, std::size_t _element_size )
+  void collision_object::set_entity_data_impl( const void *_data, std::size_t _element_size, bool _kept_assignment )
   {
     const int rank = static_cast< int >( ::vt::theContext()->getNode() );
     const auto od_factor = m_impl->overdecomposition;
 
     m_impl->num_splits = m_impl->splits.extent( 0 );
+    m_impl->restored_state = false;
 
     std::swap( m_impl->last_step_local_patches, m_impl->local_patches );
 
@@ -121,12 +301,18 @@ namespace bvh
                        "error during splitting process, splits {} do not match od factor {}\n", m_impl->num_splits + 1,
                        od_factor );
 
+    if ( m_impl->patch_rebalance_threshold > 0.0 && details::rebalance_hot_patches( *m_impl, logger() ) )
+      _kept_assignment = false;
+    m_impl->patch_assignment_kept = _kept_assignment;
+
     // Preallocate local data buffers. Do this lazily
     m_impl->narrowphase_patch_messages.resize( od_factor, nullptr );
+    m_impl->sent_patch_generation.resize( od_factor, 0 );
     auto range_policy = Kokkos::RangePolicy< Kokkos::Serial >( 0, od_factor );
 
     m_impl->m_entity_ptr = static_cast< const unsigned char * >( _data );
     m_impl->m_entity_unit_size = _element_size;
+    m_impl->m_entity_gather = nullptr;
 
     // Ensure that our update of m_impl->snapshots has finished before reading it here
     Kokkos::fence();
@@ -135,38 +321,116 @@ namespace bvh
       const auto sbeg = ( i == 0 ) ? 0 : m_impl->splits_h( i - 1 );
       const auto send = ( i == m_impl->num_splits ) ? m_impl->split_indices_h.extent( 0 ) : m_impl->splits_h( i );
       const std::size_t nelements = send - sbeg;
-      logger().debug( "creating broadphase patch for body {} size {} from offset {}", m_impl->collision_idx, nelements, sbeg );
+      SPDLOG_LOGGER_DEBUG( &logger(), "creating broadphase patch for body {} size {} from offset {}", m_impl->collision_idx, nelements, sbeg );
       m_impl->local_patches[i] = broadphase_patch_type(
         i + rank * od_factor, span< const entity_snapshot >( m_impl->snapshots.data() + sbeg, nelements ) );
     }
 
+    if ( m_impl->ships_element_trees() )
+    {
+      BVH_ASSERT_ALWAYS( !m_impl->multi_body || m_impl->body_ids.size() == m_impl->split_indices_h.extent( 0 ), logger(),
+                         "obj={} has {} body ids for {} elements\n", m_impl->collision_idx, m_impl->body_ids.size(),
+                         m_impl->split_indices_h.extent( 0 ) );
+      m_impl->element_trees.resize( od_factor );
+      std::vector< entity_snapshot > patch_snapshots;
+      for ( std::size_t i = 0; i < od_factor; ++i )
+      {
+        const auto sbeg = ( i == 0 ) ? 0 : m_impl->splits_h( i - 1 );
+        const auto send = ( i == m_impl->num_splits ) ? m_impl->split_indices_h.extent( 0 ) : m_impl->splits_h( i );
+        // Reference the elements by their position in the narrowphase payload. The leafs of a multi-body
+        // object carry the body id instead of the element id, for the body filter of the narrowphase
+        patch_snapshots.clear();
+        for ( std::size_t j = sbeg; j < send; ++j )
+        {
+          const auto &snap = m_impl->snapshots( j );
+          const auto id = m_impl->multi_body ? m_impl->body_ids[m_impl->split_indices_h( j )] : snap.global_id();
+          patch_snapshots.emplace_back( id, snap.kdop(), snap.centroid(), j - sbeg );
+        }
+        m_impl->element_trees[i] = build_tree_top_down< snapshot_tree >( patch_snapshots );
+      }
+    }
+
+    if ( !_kept_assignment )
+    {
+      m_impl->reference_patch_bounds.resize( od_factor );
+      for ( std::size_t i = 0; i < od_factor; ++i )
+        m_impl->reference_patch_bounds[i] = m_impl->local_patches[i].kdop();
+    }
+
+    // Remember the patch of every element so the next step can weight them by this step's pair counts,
+    // and report the elements that changed patches
+    m_impl->patch_membership_changes.clear();
+    if ( m_impl->patch_rebalance_threshold > 0.0 || m_impl->patch_hysteresis_growth > 0.0 )
+    {
+      const auto n = m_impl->split_indices_h.extent( 0 );
+      const bool have_previous = ( m_impl->last_element_patch.size() == n );
+      std::vector< std::size_t > element_patch( n );
+      for ( std::size_t i = 0; i < od_factor; ++i )
+      {
+        const auto sbeg = ( i == 0 ) ? 0 : m_impl->splits_h( i - 1 );
+        const auto send = ( i == m_impl->num_splits ) ? n : m_impl->splits_h( i );
+        for ( std::size_t j = sbeg; j < send; ++j )
+          element_patch[m_impl->split_indices_h( j )] = i;
+      }
+
+      if ( have_previous && !_kept_assignment )
+      {
+        for ( std::size_t e = 0; e < n; ++e )
+          if ( element_patch[e] != m_impl->last_element_patch[e] )
+            m_impl->patch_membership_changes.push_back( { e, m_impl->last_element_patch[e], element_patch[e] } );
+        SPDLOG_LOGGER_DEBUG( &logger(), "obj={} {} of {} elements changed patches", m_impl->collision_idx,
+                                        m_impl->patch_membership_changes.size(), n );
+      }
+
+      m_impl->last_element_patch = std::move( element_patch );
+    }
+    m_impl->patch_pair_counts.assign( od_factor, 0 );
+
     BVH_ASSERT_ALWAYS( m_impl->local_patches.size() == od_factor,
                        logger(),
                        "wrong number of patches\n" );
   }
 
+  void
+  collision_object::set_entity_gather( std::size_t _unit_size, entity_gather_function &&_gather )
+  {
+    m_impl->m_entity_unit_size = _unit_size;
+    m_impl->m_entity_gather = std::move( _gather );
+  }
+
   void collision_object::init_broadphase() const
   {
+    if ( auto *capture = m_impl->world->capture() )
+      capture->init_broadphase( m_impl->collision_idx );
+
     m_impl->local_results.clear();
     m_impl->active_narrowphase_indices.clear();
-    m_impl->active_narrowphase_local_index.clear();
-    m_impl->narrowphase_patch_cache.clear();
+    m_impl->active_narrowphase_local_index.assign( m_impl->overdecomposition, false );
+    m_impl->narrowphase_batches.clear();
+    m_impl->narrowphase_queue.clear();
+    ++m_impl->ghost_generation;
+
+    // This rank owns every patch, so the tree is built right away and the collections are never needed
+    if ( get_impl( *m_impl->world ).in_process )
+    {
+      if ( m_impl->build_trees )
+      {
+        ::vt::trace::TraceScopedEvent scope(bvh_build_trees_);
+        collision_object_impl::build_local_tree( *m_impl );
+      }
+      return;
+    }
 
     const int rank = static_cast< int >( ::vt::theContext()->getNode() );
     const auto od_factor = m_impl->overdecomposition;
 
-    // Now lazily construct the collection if it's necessary
-    auto coll_size = vt_index{ static_cast< std::size_t >( od_factor * ::vt::theContext()->getNumNodes() ) };
+    // Now lazily construct the collections if it's necessary
     if ( m_impl->broadphase_patch_collection_proxy.getProxy() == ::vt::no_vrt_proxy )
     {
-      logger().info( "lazily constructing broadphase patch collection with {} elements", coll_size );
-      m_impl->broadphase_patch_collection_proxy = ::vt::makeCollection< broadphase_patch_collection_type >().bounds( coll_size ).bulkInsert().wait();
-      logger().info( "lazily constructing narrophase patch collection with {} elements", coll_size );
-      m_impl->narrowphase_patch_collection_proxy = ::vt::makeCollection< narrowphase_patch_collection_type >()
-        .elementConstructor( [this]( narrowphase_patch_collection_type::IndexType ){ return std::make_unique< narrowphase_patch_collection_type >( m_impl->objgroup ); } )
-        .bounds( coll_size ).bulkInsert().wait();
-      logger().info( "lazily constructing narrowphase collection with dynamic membership" );
-      m_impl->narrowphase_collection_proxy = ::vt::makeCollection< narrowphase_collection_type >().dynamicMembership( true ).wait();
+      std::vector< ::vt::EpochType > pending;
+      make_collections( pending );
+      for ( auto &&epoch : pending )
+        ::vt::runSchedulerThrough( epoch );
     }
 
     // Update the data; od_factor should be identical across nodes
@@ -185,11 +449,11 @@ namespace bvh
         msg->patch = local_patch;
         msg->origin_node = rank;
         msg->local_idx = _local;
-        logger().debug( "<send={}> obj={} initialize broadphase patch {} size {}",
-                        vt_index{ _local.x() + offset },
-                         m_impl->collision_idx,
-                        _local.x() + offset,
-                        msg->patch.size() );
+        SPDLOG_LOGGER_DEBUG( &logger(), "<send={}> obj={} initialize broadphase patch {} size {}",
+                                        vt_index{ _local.x() + offset },
+                                         m_impl->collision_idx,
+                                        _local.x() + offset,
+                                        msg->patch.size() );
         return m_impl->broadphase_patch_collection_proxy[vt_index{ _local.x() + offset }]
           .sendMsg< broadphase_patch_msg, &details::set_broadphase_patches >( msg.get() );
       } else {
@@ -204,10 +468,10 @@ namespace bvh
       ::vt::trace::TraceScopedEvent scope(bvh_build_trees_);
       // Tree build needs to be done collectively, everyone needs to finish before the next step
       m_impl->chainset.nextStepCollective( "build_tree_step", [this, offset]( vt_index _idx ) {
-        logger().debug( "<send={}> obj={} building tree reduction for patch {}",
-                          vt_index{ _idx.x() + offset },
-                          m_impl->collision_idx,
-                          _idx.x() + offset );
+        SPDLOG_LOGGER_DEBUG( &logger(), "<send={}> obj={} building tree reduction for patch {}",
+                                          vt_index{ _idx.x() + offset },
+                                          m_impl->collision_idx,
+                                          _idx.x() + offset );
         return collision_object_impl::build_trees_top_down( vt_index{ _idx.x() + offset },
             m_impl->objgroup, m_impl->broadphase_patch_collection_proxy );
       } );
@@ -246,11 +510,46 @@ namespace bvh
   }
 
   void
-  collision_object::broadphase( collision_object &_other )
+  collision_object::stream_results_impl( std::function< void( const narrowphase_result & ) > &&_fun,
+                                         std::function< void() > &&_done )
   {
-    const auto od_factor = m_impl->overdecomposition;
-    int rank = static_cast< int >( ::vt::theContext()->getNode() );
-    std::size_t offset = rank * od_factor;
+    m_impl->result_stream = std::move( _fun );
+
+    auto epoch = ::vt::theMsg()->getEpoch();
+    SPDLOG_LOGGER_DEBUG( &logger(), "obj={} streaming results until epoch {:x} terminates", id(), epoch );
+    ::vt::theTerm()->addAction( epoch, [this, done = std::move( _done )]() {
+      m_impl->result_stream = nullptr;
+      if ( done )
+        done();
+    } );
+  }
+
+  void
+  collision_object::broadphase( collision_object &_other, broadphase_orientation _orientation )
+  {
+    if ( auto *capture = m_impl->world->capture() )
+      capture->broadphase( m_impl->collision_idx, _other.m_impl->collision_idx, _orientation );
+
+    if ( get_impl( *m_impl->world ).in_process )
+    {
+      collision_object_impl::local_broadphase( *this, _other, _orientation );
+      return;
+    }
+
+    // Both trees (and therefore both global bounds) must be available, so this has to be a merged step.
+    // If the bounds are disjoint every remaining step of this pair becomes a no-op
+    details::pair_step( "broadphase_bounds_step", *m_impl, *_other.m_impl,
+                        [this, &_other]( vt_index _local_idx ) {
+      if ( _local_idx.x() == 0 )
+      {
+        auto msg = ::vt::makeMessage< collision_object_impl::check_bounds_msg >();
+        msg->other_obj = _other.m_impl->objgroup;
+        SPDLOG_LOGGER_TRACE( &broadphase_logger(), "<send=objgroup({})> obj={} check_broadphase_bounds",
+                                                   ::vt::theContext()->getNode(), id() );
+        return m_impl->objgroup[::vt::theContext()->getNode()].sendMsg< collision_object_impl::check_bounds_msg, &collision_object_impl::collision_object_holder::check_broadphase_bounds >( msg );
+      } else
+        return pending_send{ nullptr };
+    } );
 
     m_impl->chainset.nextStepCollective( "start broadphase insertion", [this, &_other]( vt_index _local_idx) {
       if ( _local_idx.x() == 0 )
@@ -258,41 +557,45 @@ namespace bvh
         broadphase_logger().info( "starting broadphase between body {} and {}",
                                   m_impl->collision_idx, _other.m_impl->collision_idx );
         auto msg = ::vt::makeMessage< collision_object_impl::messages::modify_msg >();
-        broadphase_logger().trace( "<send=objgroup({})> obj={} begin_narrowphase_modification",
-                                   ::vt::theContext()->getNode(), id() );
+        SPDLOG_LOGGER_TRACE( &broadphase_logger(), "<send=objgroup({})> obj={} begin_narrowphase_modification",
+                                                   ::vt::theContext()->getNode(), id() );
         return m_impl->objgroup[::vt::theContext()->getNode()].sendMsg< collision_object_impl::messages::modify_msg, &collision_object_impl::collision_object_holder::begin_narrowphase_modification >( msg );
       } else
         return pending_send{ nullptr };
     } );
 
-    using chainset_type = ::vt::messaging::CollectionChainSet< vt_index >;
-    chainset_type::mergeStepCollective( "broadphase_step",m_impl->chainset, _other.m_impl->chainset,
-                                       [this, rank, offset, &_other]( vt_index _idx ) {
-      broadphase_logger().trace( "<send={}> obj={} target_obj={} start broadphase",
-                                 vt_index{ _idx.x() + offset }, id(), _other.id() );
-      return collision_object_impl::broadphase(
-        vt_index{ _idx.x() + offset }, vt_index{ _idx.x() }, rank,
-        m_impl->broadphase_patch_collection_proxy, m_impl->objgroup,
-        _other.m_impl->objgroup );
+    // The orientation depends on the trees, so it is decided per node once they are available
+    details::pair_step( "broadphase_step", *m_impl, *_other.m_impl,
+                        [this, &_other, _orientation]( vt_index _idx ) {
+      if ( _idx.x() == 0 )
+      {
+        SPDLOG_LOGGER_TRACE( &broadphase_logger(), "<send=objgroup({})> obj={} target_obj={} start broadphase",
+                                                   ::vt::theContext()->getNode(), id(), _other.id() );
+        return collision_object_impl::broadphase( _idx, m_impl->objgroup, _other.m_impl->objgroup, _orientation );
+      } else
+        return pending_send{ nullptr };
     } );
 
     m_impl->chainset.nextStepCollective( "finalize broadphase insertion", [this]( vt_index _local_idx) {
       if ( _local_idx.x() == 0 )
       {
-        broadphase_logger().trace( "<send=objgroup({})> obj={} finish_narrowphase_modification",
-                                   ::vt::theContext()->getNode(), id() );
+        SPDLOG_LOGGER_TRACE( &broadphase_logger(), "<send=objgroup({})> obj={} finish_narrowphase_modification",
+                                                   ::vt::theContext()->getNode(), id() );
         auto msg = ::vt::makeMessage< collision_object_impl::messages::modify_msg >();
         return m_impl->objgroup[::vt::theContext()->getNode()].sendMsg< collision_object_impl::messages::modify_msg, &collision_object_impl::collision_object_holder::finish_narrowphase_modification >( msg );
       } else
         return pending_send{ nullptr };
     } );
 
+    // A multi-body object colliding with itself only sets up its patches once
 #ifdef BVH_COPY_ALL_NARROWPHASE_PATCHES
     this->set_all_narrow_patches();
-    _other.set_all_narrow_patches();
+    if ( &_other != this )
+      _other.set_all_narrow_patches();
 #else
     this->set_active_narrow_patches();
-    _other.set_active_narrow_patches();
+    if ( &_other != this )
+      _other.set_active_narrow_patches();
 #endif
     //
     this->narrowphase(_other);
@@ -339,15 +642,11 @@ namespace bvh
 
   void
   collision_object::narrowphase(collision_object &_other ){
-    const auto od_factor = m_impl->overdecomposition;
-    int rank = static_cast< int >( ::vt::theContext()->getNode() );
-    std::size_t offset = rank * od_factor;
     // After the last step, all elements of the narrowphase collection
     // have been inserted
 
     // We need to activate them
-    using chainset_type = ::vt::messaging::CollectionChainSet< vt_index >;
-    chainset_type::mergeStepCollective( "activate_narrowphase_step", m_impl->chainset, _other.m_impl->chainset,
+    details::pair_step( "activate_narrowphase_step", *m_impl, *_other.m_impl,
     [this]( vt_index _idx ) {
       if ( _idx.x() == 0 )
         return collision_object_impl::activate_narrowphase( _idx, this->m_impl->objgroup );
@@ -355,8 +654,11 @@ namespace bvh
         return pending_send{ nullptr };
     } );
 
-    // Proceed with narrowphase
-    m_impl->chainset.nextStepCollective( "request_ghosts", [this, &_other]( vt_index _idx ){
+    // Proceed with narrowphase. Ghosts are sent as soon as they are requested and every pair runs
+    // as soon as both of its patches are cached on its node, so this single step covers ghosting
+    // and the narrowphase itself
+    details::pair_step( "narrowphase", *m_impl, *_other.m_impl,
+    [this, &_other]( vt_index _idx ){
       if ( _idx.x() == 0 ) {
         return collision_object_impl::request_ghosts( _idx, m_impl->objgroup, _other.m_impl->objgroup );
       } else {
@@ -364,28 +666,29 @@ namespace bvh
       }
     } );
 
-    // TODO: make this just nextStep and cause it to trigger individual narrowphases
-    m_impl->chainset.nextStepCollective( "ghost_this", [this, offset]( vt_index _local_idx ){
-      return collision_object_impl::ghost( vt_index{ _local_idx.x() + offset},
-      m_impl->objgroup,
-      m_impl->narrowphase_patch_collection_proxy );
-    } );
-
-    m_impl->chainset.nextStepCollective( "ghost_other", [offset, &_other]( vt_index _local_idx ){
-      return collision_object_impl::ghost( vt_index{ _local_idx.x() + offset},
-      _other.m_impl->objgroup,
-      _other.m_impl->narrowphase_patch_collection_proxy );
-    } );
-
-    using chainset_type = ::vt::messaging::CollectionChainSet< vt_index >;
-    chainset_type::mergeStepCollective( "narrowphase", m_impl->chainset,
-    _other.m_impl->chainset, [this]( vt_index _idx ){
-      if ( _idx.x() == 0 ) {
-        return collision_object_impl::narrowphase( _idx, m_impl->objgroup );
-      } else {
-        return pending_send{ nullptr };
-      }
-    } );
+    // With a batched functor the pairs above were only collected, run them now that every pair
+    // of this node has its patches cached
+    if ( get_impl( *m_impl->world ).batch_functor )
+    {
+      details::pair_step( "narrowphase_batches", *m_impl, *_other.m_impl,
+      [this, &_other]( vt_index _idx ){
+        if ( _idx.x() == 0 ) {
+          return collision_object_impl::run_narrowphase_batches( _idx, m_impl->objgroup, _other.m_impl->objgroup );
+        } else {
+          return pending_send{ nullptr };
+        }
+      } );
+    } else if ( get_impl( *m_impl->world ).parallel_narrowphase ) {
+      // The pairs above were only queued, run all of them of this node at once
+      details::pair_step( "narrowphase_parallel", *m_impl, *_other.m_impl,
+      [this, &_other]( vt_index _idx ){
+        if ( _idx.x() == 0 ) {
+          return collision_object_impl::run_queued_narrowphase( _idx, m_impl->objgroup, _other.m_impl->objgroup );
+        } else {
+          return pending_send{ nullptr };
+        }
+      } );
+    }
 
     m_impl->chainset.nextStepCollective( "clear_narrowphase_step", [this]( vt_index _idx ){
       if (_idx.x() == 0) {
@@ -402,6 +705,472 @@ namespace bvh
     m_impl->chainset.phaseDone();
   }
 
+  void
+  collision_object::set_build_trees( bool _build ) noexcept
+  {
+    m_impl->build_trees = _build;
+  }
+
+  bool
+  collision_object::build_trees() const noexcept
+  {
+    return m_impl->build_trees;
+  }
+
+  void
+  collision_object::set_element_trees( bool _build ) noexcept
+  {
+    m_impl->build_element_trees = _build;
+    if ( !_build )
+      m_impl->element_trees.clear();
+  }
+
+  bool
+  collision_object::element_trees() const noexcept
+  {
+    return m_impl->build_element_trees;
+  }
+
+  void
+  collision_object::set_compact_split( bool _compact ) noexcept
+  {
+    m_impl->compact_split = _compact;
+    if ( !_compact )
+      m_impl->compact_snapshots = {};
+  }
+
+  bool
+  collision_object::compact_split() const noexcept
+  {
+    return m_impl->compact_split;
+  }
+
+  bool
+  collision_object::multi_body() const noexcept
+  {
+    return m_impl->multi_body;
+  }
+
+  void
+  collision_object::log_clustering( std::size_t _num_elements ) const
+  {
+    SPDLOG_LOGGER_DEBUG( &logger(), "obj={} clustering {} elements", id(), _num_elements );
+  }
+
+  void
+  collision_object::set_body_ids( bool _multi_body, std::vector< std::size_t > &&_body_ids )
+  {
+    m_impl->multi_body = _multi_body;
+    m_impl->body_ids = std::move( _body_ids );
+    if ( !m_impl->ships_element_trees() )
+      m_impl->element_trees.clear();
+  }
+
+  void
+  collision_object::set_patch_rebalance_threshold( double _threshold ) noexcept
+  {
+    m_impl->patch_rebalance_threshold = _threshold;
+    if ( _threshold <= 0.0 && m_impl->patch_hysteresis_growth <= 0.0 )
+      m_impl->last_element_patch.clear();
+  }
+
+  void
+  collision_object::set_patch_hysteresis( double _max_bounds_growth, double _max_imbalance ) noexcept
+  {
+    m_impl->patch_hysteresis_growth = _max_bounds_growth;
+    m_impl->patch_hysteresis_imbalance = _max_imbalance;
+    if ( _max_bounds_growth <= 0.0 )
+    {
+      m_impl->reference_patch_bounds.clear();
+      if ( m_impl->patch_rebalance_threshold <= 0.0 )
+        m_impl->last_element_patch.clear();
+    }
+  }
+
+  void
+  collision_object::set_adaptive_overdecomposition( std::size_t _min_od, std::size_t _max_od, std::size_t _sample_steps,
+                                                    double _min_gain )
+  {
+    auto is_pow2 = []( std::size_t _v ) { return _v > 0 && ( _v & ( _v - 1 ) ) == 0; };
+    BVH_ASSERT_ALWAYS( _max_od == 0 || ( is_pow2( _min_od ) && is_pow2( _max_od ) && _min_od <= _max_od ), logger(),
+                       "adaptive overdecomposition bounds [{}, {}] must be ordered powers of two\n", _min_od, _max_od );
+
+    m_impl->adaptive_od_min = _min_od;
+    m_impl->adaptive_od_max = _max_od;
+    m_impl->adaptive_od_sample_steps = std::max< std::size_t >( _sample_steps, 1 );
+    m_impl->adaptive_od_min_gain = _min_gain;
+    m_impl->adaptive_od_steps = 0;
+    m_impl->local_phase_times = {};
+  }
+
+  void
+  collision_object::adapt_overdecomposition()
+  {
+    auto &impl = *m_impl;
+    if ( !impl.adaptive_overdecomposition() )
+      return;
+
+    // Nothing was timed before the first step. Every rank runs the same steps, so they agree on the count
+    if ( impl.ghost_generation == 0 || ++impl.adaptive_od_steps < impl.adaptive_od_sample_steps )
+      return;
+
+    const auto costs = reduce_phase_times( impl.objgroup, impl.local_phase_times );
+    impl.adaptive_od_steps = 0;
+    impl.local_phase_times = {};
+
+    const std::size_t od = choose_overdecomposition( costs, impl.overdecomposition, impl.adaptive_od_min,
+                                                     impl.adaptive_od_max, impl.adaptive_od_min_gain );
+    SPDLOG_LOGGER_DEBUG( &logger(), "obj={} max phase times broadphase={} ghosting={} narrowphase={}, od {} -> {}",
+                                    impl.collision_idx, costs.max.broadphase, costs.max.ghosting, costs.max.narrowphase,
+                                    impl.overdecomposition, od );
+    if ( od != impl.overdecomposition )
+    {
+      logger().info( "obj={} changing overdecomposition factor from {} to {}", impl.collision_idx,
+                     impl.overdecomposition, od );
+      set_overdecomposition( od );
+    }
+  }
+
+  void
+  collision_object::set_overdecomposition( std::size_t _od )
+  {
+    auto &impl = *m_impl;
+
+    for ( std::size_t i = _od; i < impl.overdecomposition; ++i )
+      impl.chainset.removeIndex( vt_index{ i } );
+    for ( std::size_t i = impl.overdecomposition; i < _od; ++i )
+      impl.chainset.addIndex( vt_index{ i } );
+    impl.overdecomposition = _od;
+
+    // The collections are sized by the factor, `init_broadphase` constructs them again
+    if ( impl.broadphase_patch_collection_proxy.getProxy() != ::vt::no_vrt_proxy )
+    {
+      impl.broadphase_patch_collection_proxy.destroy();
+      impl.narrowphase_patch_collection_proxy.destroy();
+      impl.narrowphase_collection_proxy.destroy();
+      impl.broadphase_patch_collection_proxy = ::vt::no_vrt_proxy;
+      impl.narrowphase_patch_collection_proxy = ::vt::no_vrt_proxy;
+      impl.narrowphase_collection_proxy = ::vt::no_vrt_proxy;
+    }
+
+    // Every patch is new, so it is sent again and nothing of the old assignment can be kept
+    impl.local_patches.assign( _od, broadphase_patch_type{} );
+    impl.narrowphase_patch_messages.assign( _od, nullptr );
+    impl.sent_patch_generation.assign( _od, 0 );
+    impl.patch_pair_counts.assign( _od, 0 );
+    impl.reference_patch_bounds.clear();
+    impl.last_element_patch.clear();
+    impl.element_trees.clear();
+    impl.restored_state = false;
+  }
+
+  bool
+  collision_object::patch_assignment_kept() const noexcept
+  {
+    return m_impl->patch_assignment_kept;
+  }
+
+  span< const patch_membership_change >
+  collision_object::patch_membership_changes() const noexcept
+  {
+    return span< const patch_membership_change >( m_impl->patch_membership_changes.data(),
+                                                  m_impl->patch_membership_changes.size() );
+  }
+
+  void
+  collision_object::save_state( const std::string &_path ) const
+  {
+    const auto &impl = *m_impl;
+
+    details::saved_state state;
+    state.overdecomposition = impl.overdecomposition;
+    state.split_indices.assign( impl.split_indices_h.data(), impl.split_indices_h.data() + impl.split_indices_h.extent( 0 ) );
+    state.splits.assign( impl.splits_h.data(), impl.splits_h.data() + impl.splits_h.extent( 0 ) );
+    state.reference_patch_bounds = impl.reference_patch_bounds;
+    state.last_element_patch = impl.last_element_patch;
+    state.patch_pair_counts = impl.patch_pair_counts;
+
+    auto buffer = ::checkpoint::serialize( state );
+
+    details::saved_state_header header;
+    header.magic = details::saved_state_magic;
+    header.version = details::saved_state_version;
+    header.size = buffer->getSize();
+    header.checksum = details::state_checksum( buffer->getBuffer(), buffer->getSize() );
+
+    std::ofstream out( _path, std::ios::binary | std::ios::trunc );
+    out.write( reinterpret_cast< const char * >( &header ), sizeof( header ) );
+    out.write( buffer->getBuffer(), static_cast< std::streamsize >( buffer->getSize() ) );
+    if ( !out )
+      throw state_file_exception( _path, "could not write the file" );
+
+    SPDLOG_LOGGER_DEBUG( &logger(), "obj={} saved state of {} elements to {}", impl.collision_idx, state.split_indices.size(), _path );
+  }
+
+  void
+  collision_object::load_state( const std::string &_path )
+  {
+    std::ifstream in( _path, std::ios::binary | std::ios::ate );
+    if ( !in )
+      throw state_file_exception( _path, "could not open the file" );
+    const auto file_size = static_cast< std::uint64_t >( in.tellg() );
+    in.seekg( 0 );
+
+    // Validate the whole payload before handing it to the deserializer, which trusts its input
+    details::saved_state_header header;
+    if ( file_size < sizeof( header ) || !in.read( reinterpret_cast< char * >( &header ), sizeof( header ) ) )
+      throw state_file_exception( _path, "truncated" );
+    if ( header.magic != details::saved_state_magic )
+      throw state_file_exception( _path, "not a state file" );
+    if ( header.version != details::saved_state_version )
+      throw state_file_exception( _path, "unsupported version" );
+    if ( header.size != file_size - sizeof( header ) )
+      throw state_file_exception( _path, "truncated" );
+
+    std::vector< char > payload( header.size );
+    if ( !in.read( payload.data(), static_cast< std::streamsize >( payload.size() ) ) )
+      throw state_file_exception( _path, "truncated" );
+    if ( details::state_checksum( payload.data(), payload.size() ) != header.checksum )
+      throw state_file_exception( _path, "checksum mismatch" );
+
+    auto state = ::checkpoint::deserialize< details::saved_state >( payload.data() );
+    auto &impl = *m_impl;
+
+    // Nothing is modified before these checks, so the caller can fall back to a cold start
+    if ( const char *reason = details::invalid_state_reason( *state, impl.overdecomposition ) )
+      throw state_file_exception( _path, reason );
+
+    m_last_permutations.indices = std::move( state->split_indices );
+    m_last_permutations.splits = std::move( state->splits );
+    initialize_split_indices( m_last_permutations );
+    impl.num_splits = impl.splits_h.extent( 0 );
+
+    impl.reference_patch_bounds = std::move( state->reference_patch_bounds );
+    impl.last_element_patch = std::move( state->last_element_patch );
+    impl.patch_pair_counts = std::move( state->patch_pair_counts );
+    impl.restored_state = true;
+
+    SPDLOG_LOGGER_DEBUG( &logger(), "obj={} loaded state of {} elements from {}", impl.collision_idx,
+                                    impl.split_indices_h.extent( 0 ), _path );
+  }
+
+  void
+  collision_object::global_morton_permutations( element_permutations &_permutations )
+  {
+    const auto &snapshots = m_impl->snapshots;
+    const std::size_t n = snapshots.extent( 0 );
+    const auto od_factor = m_impl->overdecomposition;
+    const auto num_nodes = static_cast< std::size_t >( ::vt::theContext()->getNumNodes() );
+
+    // Ensure that our update of m_impl->snapshots has finished before reading it here
+    Kokkos::fence();
+
+    kdop_type local_bounds;
+    for ( std::size_t i = 0; i < n; ++i )
+      local_bounds.union_with( snapshots( i ).kdop() );
+
+    const auto bounds = collision_object_impl::reduce_global_morton_bounds( m_impl->objgroup, local_bounds );
+    const auto &bmin = bounds.cardinal_min();
+    const auto &bmax = bounds.cardinal_max();
+
+    // Quantize in the frame of the whole object so that keys of different ranks are comparable.
+    // Clamp instead of relying on quantize32, which wraps the upper bound around to 0
+    std::vector< std::pair< morton32_t, std::size_t > > keyed( n );
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+      const auto c = snapshots( i ).centroid();
+      m::vec3< std::uint32_t > q;
+      for ( int d = 0; d < 3; ++d )
+      {
+        const double width = bmax[d] - bmin[d];
+        const double norm = ( width > 0.0 ) ? ( c[d] - bmin[d] ) / width : 0.0;
+        q[d] = static_cast< std::uint32_t >( std::clamp( norm, 0.0, 1.0 ) * 1023.0 );
+      }
+      keyed[i] = { morton( q ), i };
+    }
+    std::sort( keyed.begin(), keyed.end() );
+
+    std::vector< morton32_t > keys( n );
+    _permutations.indices.resize( n );
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+      keys[i] = keyed[i].first;
+      _permutations.indices[i] = keyed[i].second;
+    }
+
+    // Every rank contributes as many samples as it has patches, so ranks with more patches get a finer say
+    const auto splitters = collision_object_impl::reduce_global_morton_splitters(
+      m_impl->objgroup, regular_samples< morton32_t >( keys, od_factor ), num_nodes * od_factor );
+    _permutations.splits = coherent_splits< morton32_t >( keys, splitters, od_factor - 1 );
+
+    SPDLOG_LOGGER_DEBUG( &logger(), "obj={} global morton split of {} elements with {} splitters", m_impl->collision_idx, n,
+                                    splitters.size() );
+  }
+
+  void
+  collision_object::split_snapshots( split_algorithm _algorithm )
+  {
+    auto &snapshots = m_impl->snapshots;
+    const std::size_t n = snapshots.extent( 0 );
+    const auto od_factor = m_impl->overdecomposition;
+    const int depth = bit_log2( od_factor );
+
+    // The snapshots need to finish updating
+    Kokkos::fence();
+
+    switch ( _algorithm )
+    {
+      case split_algorithm::geom_axis:
+      {
+        ::vt::trace::TraceScopedEvent scope( this->bvh_splitting_geom_axis_ );
+        split_permutations< split::mean, axis::longest, entity_snapshot >(
+          span< const entity_snapshot >( snapshots.data(), n ), depth, &m_last_permutations );
+        initialize_split_indices( m_last_permutations );
+        permute_snapshots();
+        break;
+      }
+      case split_algorithm::ml_geom_axis:
+      {
+        // Permutes the snapshots in place
+        ::vt::trace::TraceScopedEvent scope( this->bvh_splitting_ml_ );
+        split_permutations_ml< split::mean, axis::longest, entity_snapshot >( snapshots, depth, &m_last_permutations );
+        initialize_split_indices( m_last_permutations );
+        break;
+      }
+      case split_algorithm::clustering:
+      {
+        ::vt::trace::TraceScopedEvent scope( this->bvh_clustering_ );
+        if ( n != m_clusterer.size() )
+          m_clusterer.resize( n );
+
+        auto &split_indices = m_impl->split_indices;
+        Kokkos::resize( Kokkos::WithoutInitializing, split_indices, n );
+        Kokkos::resize( Kokkos::WithoutInitializing, m_impl->split_indices_h, n );
+        Kokkos::resize( Kokkos::WithoutInitializing, m_impl->splits, od_factor - 1 );
+        Kokkos::resize( Kokkos::WithoutInitializing, m_impl->splits_h, od_factor - 1 );
+
+        Kokkos::parallel_for(
+          n, KOKKOS_LAMBDA( int _i ) { split_indices( _i ) = _i; } );
+
+        m_clusterer( view< const entity_snapshot * >( snapshots ), split_indices, m_impl->splits );
+
+        Kokkos::deep_copy( m_impl->splits_h, m_impl->splits );
+        Kokkos::deep_copy( m_impl->split_indices_h, split_indices );
+        permute_snapshots();
+        break;
+      }
+      case split_algorithm::global_morton:
+      {
+        ::vt::trace::TraceScopedEvent scope( this->bvh_clustering_ );
+        global_morton_permutations( m_last_permutations );
+        initialize_split_indices( m_last_permutations );
+        permute_snapshots();
+        break;
+      }
+    }
+  }
+
+  void
+  collision_object::permute_snapshots()
+  {
+    const auto &snapshots = m_impl->snapshots;
+    const auto &ind = m_impl->split_indices_h;
+    view< entity_snapshot * > permuted( "PermutedSnapshots", snapshots.extent( 0 ) );
+    Kokkos::parallel_for(
+      snapshots.extent( 0 ), KOKKOS_LAMBDA( int _i ) { permuted( _i ) = snapshots( ind( _i ) ); } );
+    Kokkos::fence();
+    m_impl->snapshots = permuted;
+  }
+
+  bool
+  collision_object::capturing() const noexcept
+  {
+    return m_impl->world->capture() != nullptr;
+  }
+
+  void
+  collision_object::capture_snapshots( split_algorithm _algorithm, std::size_t _element_size,
+                                       span< const entity_snapshot > _snapshots )
+  {
+    m_impl->world->capture()->set_entity_data( m_impl->collision_idx, _algorithm, _element_size, _snapshots );
+  }
+
+  void
+  collision_object::capture_permuted_snapshots( split_algorithm _algorithm, std::size_t _element_size )
+  {
+    Kokkos::fence();
+    const auto &snapshots = m_impl->snapshots;
+    std::vector< entity_snapshot > original( snapshots.extent( 0 ) );
+    for ( std::size_t j = 0; j < snapshots.extent( 0 ); ++j )
+      original[snapshots( j ).local_index()] = snapshots( j );
+    capture_snapshots( _algorithm, _element_size, original );
+  }
+
+  bool
+  collision_object::can_keep_patch_assignment( std::size_t _num_elements ) const
+  {
+    const auto &impl = *m_impl;
+    if ( ( impl.patch_hysteresis_growth <= 0.0 && !impl.restored_state ) || _num_elements == 0 )
+      return false;
+
+    // Nothing to keep
+    if ( impl.split_indices_h.extent( 0 ) != _num_elements || impl.reference_patch_bounds.size() != impl.overdecomposition )
+      return false;
+
+    if ( impl.patch_hysteresis_imbalance > 0.0 )
+    {
+      const auto loads = details::last_step_patch_loads( impl );
+      const double imbalance = max_load_imbalance( loads );
+      if ( imbalance > impl.patch_hysteresis_imbalance )
+      {
+        SPDLOG_LOGGER_DEBUG( &logger(), "obj={} patch load imbalance {} exceeds {}, re-splitting", impl.collision_idx, imbalance,
+                                        impl.patch_hysteresis_imbalance );
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool
+  collision_object::keep_patch_assignment( const void *_data, std::size_t _element_size )
+  {
+    auto &impl = *m_impl;
+    const std::size_t od_factor = impl.overdecomposition;
+    const std::size_t n = impl.split_indices_h.extent( 0 );
+
+    // Snapshots have to be updated before looking at the new bounds
+    Kokkos::fence();
+
+    // A restored assignment is kept regardless of the bounds when hysteresis is off
+    for ( std::size_t i = 0; i < od_factor && impl.patch_hysteresis_growth > 0.0; ++i )
+    {
+      const auto sbeg = ( i == 0 ) ? 0 : impl.splits_h( i - 1 );
+      const auto send = ( i + 1 == od_factor ) ? n : impl.splits_h( i );
+      if ( sbeg == send )
+        continue;
+
+      auto bounds = impl.snapshots( sbeg ).kdop();
+      for ( std::size_t j = sbeg + 1; j < send; ++j )
+        bounds.union_with( impl.snapshots( j ).kdop() );
+
+      const double reference = details::extent_measure( impl.reference_patch_bounds[i] );
+      const double current = details::extent_measure( bounds );
+      if ( current > reference * ( 1.0 + impl.patch_hysteresis_growth ) )
+      {
+        SPDLOG_LOGGER_DEBUG( &logger(), "obj={} bounds of patch {} grew from {} to {}, re-splitting", impl.collision_idx, i,
+                                        reference, current );
+        return false;
+      }
+    }
+
+    {
+      ::vt::trace::TraceScopedEvent scope( this->bvh_set_entity_data_impl_ );
+      set_entity_data_impl( _data, _element_size, true );
+    }
+    return true;
+  }
+
   int
   collision_object::overdecomposition_factor() const noexcept
   {
@@ -420,6 +1189,12 @@ namespace bvh
     return m_impl->snapshots;
   }
 
+  view< bvh::compact_entity_snapshot * > &
+  collision_object::get_compact_snapshots()
+  {
+    return m_impl->compact_snapshots;
+  }
+
   view< std::size_t * > &
   collision_object::get_split_indices()
   {
@@ -34,12 +34,18 @@
 #define INC_BVH_COLLISION_OBJECT_HPP
 
 #include <cstddef>
+#include <cstring>
+#include <limits>
 #include <memory>
 #include <functional>
+#include <string>
+#include <vector>
+#include <type_traits>
 #include <vt/context/context.h>
 #include <spdlog/spdlog.h>
 
 #include "snapshot.hpp"
+#include "mesh_element.hpp"
 #include "split/split.hpp"
 #include "split/mean.hpp"
 #include "split/axis.hpp"
@@ -75,12 +81,113 @@ namespace bvh
     template< typename T, typename... ViewProp, typename = std::enable_if_t< !std::is_same< entity_snapshot, T >::value > >
     void set_entity_data( Kokkos::View< const T *, ViewProp... > _data, split_algorithm _algorithm )
     {
-      switch ( _algorithm )
+      if ( capturing() )
+        capture_entity_data( _data, _algorithm );
+
+      set_entity_data_elements( _data, _algorithm );
+    }
+
+    /// \brief Set the entity data, shipping only a projection of each element to the narrowphase
+    ///
+    /// The elements are split and bounded exactly like `set_entity_data( _data, _algorithm )`, but the narrowphase
+    /// payload of every element is `_projection( element )`. Fields the narrowphase never reads therefore don't get
+    /// ghosted. The narrowphase functor must be registered for the projected type, e.g.
+    /// `world.set_narrowphase_functor< Narrow >( ... )`, and receives `span< const Narrow >`.
+    ///
+    /// \param[in] _data        the elements; must stay valid until the narrowphase finished
+    /// \param[in] _algorithm   the splitting algorithm
+    /// \param[in] _projection  callable taking a `const T &` and returning a trivially copyable type
+    template< typename T, typename Projection, typename... ViewProp, typename = std::enable_if_t< !std::is_same< entity_snapshot, T >::value > >
+    void set_entity_data( Kokkos::View< T *, ViewProp... > _data_view, split_algorithm _algorithm, Projection _projection )
+    {
+      set_entity_data( view< const T * >( std::move( _data_view ) ), _algorithm, std::move( _projection ) );
+    }
+
+    template< typename T, typename Projection, typename... ViewProp, typename = std::enable_if_t< !std::is_same< entity_snapshot, T >::value > >
+    void set_entity_data( Kokkos::View< const T *, ViewProp... > _data, split_algorithm _algorithm, Projection _projection )
+    {
+      using narrow_type = std::decay_t< std::invoke_result_t< Projection &, const T & > >;
+      static_assert( std::is_trivially_copyable_v< narrow_type >,
+                     "the narrowphase projection must produce a trivially copyable type" );
+
+      // The capture records the projected size, since that is what gets shipped to the narrowphase
+      if ( capturing() )
+        capture_entity_data( _data, _algorithm, sizeof( narrow_type ) );
+
+      set_entity_data_elements( _data, _algorithm );
+
+      // This assumes _data is on host, same as the unprojected payload
+      set_entity_gather( sizeof( narrow_type ), [_data, _projection]( span< const std::size_t > _indices, unsigned char *_dst ) {
+        for ( std::size_t j = 0; j < _indices.size(); ++j )
+        {
+          const narrow_type n = _projection( _data( _indices[j] ) );
+          std::memcpy( _dst + j * sizeof( narrow_type ), &n, sizeof( narrow_type ) );
+        }
+      } );
+    }
+
+    /// \brief Set the entity data from node coordinates and element connectivity
+    ///
+    /// Element `i` is spanned by the nodes `_connectivity( i, 0 )` to `_connectivity( i, N - 1 )`, whose coordinates
+    /// are rows of `_coordinates`. The snapshots are computed from the views in one Kokkos kernel, straight into the
+    /// snapshots of the object, and then split and permuted into patch order; if the patch assignment is kept they are
+    /// computed in patch order directly. `set_compact_split` does not apply here. The narrowphase payloads of a patch
+    /// are gathered from the views into `mesh_element< N >` when it is sent, so the narrowphase functor must be
+    /// registered for `mesh_element< N >`.
+    ///
+    /// \param[in] _coordinates   node coordinates, a view of `[3]` rows; must stay valid until the narrowphase finished
+    /// \param[in] _connectivity  node indices, a view of `[N]` rows with `N` known at compile time; must stay valid too
+    /// \param[in] _global_ids    the global id of each element
+    /// \param[in] _algorithm     the splitting algorithm
+    template< typename CoordView, typename ConnView, typename IdView >
+    void set_entity_data( const CoordView &_coordinates, const ConnView &_connectivity, const IdView &_global_ids,
+                          split_algorithm _algorithm )
+    {
+      static_assert( CoordView::rank == 2 && ConnView::rank == 2 && IdView::rank == 1,
+                     "expected coordinates and connectivity rows and a global id per element" );
+      constexpr std::size_t num_nodes = ConnView::static_extent( 1 );
+      static_assert( num_nodes > 0, "the connectivity needs a compile time number of nodes per element" );
+      using element_type = mesh_element< num_nodes >;
+
+      always_assert( _global_ids.extent( 0 ) == _connectivity.extent( 0 ), "must have a global id per element!" );
+
+      // This assumes the views are on host, same as the narrowphase payload
+      const std::size_t n = _connectivity.extent( 0 );
+      auto make = KOKKOS_LAMBDA( std::size_t _i ) {
+        return detail::make_mesh_snapshot( _coordinates, _connectivity, _global_ids( _i ), _i );
+      };
+
+      set_body_ids( false, {} );
+      adapt_overdecomposition();
+
+      // Same as `try_keep_patch_assignment`, but the snapshots are made from the views
+      bool kept = false;
+      if ( _algorithm != split_algorithm::global_morton && can_keep_patch_assignment( n ) )
       {
-        case split_algorithm::geom_axis: set_entity_data_geom_axis( _data ); break;
-        case split_algorithm::ml_geom_axis: set_entity_data_ml_geom_axis( _data ); break;
-        case split_algorithm::clustering: set_entity_data_clustering( _data ); break;
+        update_snapshots_with( n, make, true );
+        kept = keep_patch_assignment( nullptr, sizeof( element_type ) );
+      }
+
+      if ( !kept )
+      {
+        update_snapshots_with( n, make, false );
+        split_snapshots( _algorithm );
+        set_entity_data_impl( nullptr, sizeof( element_type ) );
       }
+
+      if ( capturing() )
+        capture_permuted_snapshots( _algorithm, sizeof( element_type ) );
+
+      set_entity_gather( sizeof( element_type ), [_coordinates, _connectivity, _global_ids]( span< const std::size_t > _indices,
+                                                                                            unsigned char *_dst ) {
+        auto *dst = reinterpret_cast< element_type * >( _dst );
+        for ( std::size_t j = 0; j < _indices.size(); ++j )
+        {
+          const auto i = _indices[j];
+          const element_type e = detail::make_mesh_element( _coordinates, _connectivity, _global_ids( i ), i );
+          std::memcpy( dst + j, &e, sizeof( element_type ) );
+        }
+      } );
     }
 
     /// \brief Set up data for the broadphase (including the tree)
@@ -97,7 +204,7 @@ namespace bvh
         const auto od_factor = this->overdecomposition_factor();
         const auto num_splits = od_factor - 1;
 
-        logger().debug( "obj={} clustering {} elements\n", id(), n  );
+        log_clustering( n );
         if ( n != m_clusterer.size() )
         {
           m_clusterer.resize( n );
@@ -112,7 +219,13 @@ namespace bvh
         Kokkos::parallel_for(
           n, KOKKOS_LAMBDA( int _i ) { get_split_indices()( _i ) = _i; } );
 
-        m_clusterer( _data_view, get_split_indices(), get_splits() );
+        if ( compact_split() )
+        {
+          update_compact_snapshots( _data_view );
+          m_clusterer( view< const compact_entity_snapshot * >( get_compact_snapshots() ), get_split_indices(), get_splits() );
+        } else {
+          m_clusterer( _data_view, get_split_indices(), get_splits() );
+        }
 
         Kokkos::deep_copy( get_splits_h(), get_splits() );
         Kokkos::deep_copy( get_split_indices_h(), get_split_indices() );
@@ -121,7 +234,10 @@ namespace bvh
         // It provides a mapping from original indices to the new reordered elements that
         // are clustered by locality
 
-        update_snapshots( _data_view );
+        if ( compact_split() )
+          update_snapshots_from_compact( _data_view );
+        else
+          update_snapshots( _data_view );
       }
       // This assumes _data_view is on host for now... at the moment we can't do much better
       {
@@ -157,7 +273,34 @@ namespace bvh
       const auto od_factor = this->overdecomposition_factor();
       int depth = bit_log2( od_factor );
       ::vt::trace::TraceScopedEvent scope( this->bvh_splitting_geom_axis_ );
-      split_permutations< split::mean, axis::longest, T >( _data, depth, &m_last_permutations );
+      if ( compact_split() )
+      {
+        update_compact_snapshots( _data );
+        Kokkos::fence();  // snapshots need to finish updating
+        const auto &compact = get_compact_snapshots();
+        split_permutations< split::mean, axis::longest, compact_entity_snapshot >(
+          span< const compact_entity_snapshot >( compact.data(), compact.extent( 0 ) ), depth, &m_last_permutations );
+      } else {
+        split_permutations< split::mean, axis::longest, T >( _data, depth, &m_last_permutations );
+      }
+      set_entity_data_with_permutations( _data, m_last_permutations, std::move( scope ), compact_split() );
+    }
+
+    /// \brief Split the local elements along a morton curve, snapping the cuts to key ranges shared by every rank
+    ///
+    /// The keys are computed in the bounds of the whole object, so they are comparable across ranks. Each rank sorts
+    /// its own elements by key and moves every patch boundary to the nearest boundary of the global key ranges,
+    /// chosen by a sample sort of the keys of every rank, if that is within half a patch. The elements stay on the
+    /// rank that set them, so patches only ever contain local elements; where the domain decompositions interleave,
+    /// patches of different ranks still cover overlapping parts of the curve.
+    ///
+    /// This is collective, every rank has to call it for the step, even without elements.
+    template< typename T, typename... ViewProp >
+    void set_entity_data_global_morton( Kokkos::View< const T *, ViewProp... > _data )
+    {
+      update_snapshots_without_permuting( _data );
+      ::vt::trace::TraceScopedEvent scope( this->bvh_clustering_ );
+      global_morton_permutations( m_last_permutations );
       set_entity_data_with_permutations( _data, m_last_permutations, std::move( scope ) );
     }
 
@@ -167,7 +310,123 @@ namespace bvh
       for_each_tree_impl( tree_function{ std::forward< F >( _fun ) } );
     }
 
-    void broadphase( collision_object &_other );
+    /// \brief Find the potentially colliding patches of this object and `_other` and run the narrowphase on them
+    ///
+    /// \param[in] _other        the object to collide with
+    /// \param[in] _orientation  which object supplies the patches queried against the other object's tree.
+    ///                          With `broadphase_orientation::automatic` an object that does not build trees
+    ///                          always supplies the patches.
+    void broadphase( collision_object &_other,
+                     broadphase_orientation _orientation = broadphase_orientation::this_patches );
+
+    /// \brief Set whether `init_broadphase` builds the tree of this object
+    ///
+    /// Objects that are only ever queried with their patches do not need a tree. This must be set
+    /// identically on every rank.
+    void set_build_trees( bool _build ) noexcept;
+
+    bool build_trees() const noexcept;
+
+    /// \brief Set whether `set_entity_data` builds an element-level tree for every local patch
+    ///
+    /// The element trees are ghosted along with the narrowphase payloads and cached on the receiving node. When
+    /// both patches of a pair have one, the elements are culled tree-vs-tree before the narrowphase functor is
+    /// invoked: pairs without overlapping elements are skipped, and the others receive the overlapping element
+    /// pairs in `broadphase_collision::element_candidates`.
+    void set_element_trees( bool _build ) noexcept;
+
+    bool element_trees() const noexcept;
+
+    /// \brief Set whether the `geom_axis` and `clustering` splits run on compact snapshots of the elements
+    ///
+    /// `set_entity_data` then makes a \ref compact_entity_snapshot of every element in one pass, and the split or
+    /// clustering kernels stream through those instead of through the elements. The full snapshots are widened from
+    /// the compact ones afterwards, so the bounds of the elements are only computed once and the patch bounds are
+    /// rounded outward to float precision. The compact snapshots have float centroids, so the split may differ
+    /// slightly from the one of the elements. At most \f$2^{32}\f$ elements per rank are supported.
+    void set_compact_split( bool _compact ) noexcept;
+
+    bool compact_split() const noexcept;
+
+    /// \brief Whether the elements of this object belong to many bodies
+    ///
+    /// Set by `set_entity_data` when the element type has a body id (see `has_body_id_v`). The patches and trees of
+    /// a multi-body object span many bodies and every patch gets an element tree. Colliding the object with itself,
+    /// `obj.broadphase( obj )`, then finds the contacts between its bodies: the elements of the same body are
+    /// filtered in the element tree leaf test, and each pair of elements is passed to the narrowphase only once
+    /// in `broadphase_collision::element_candidates`, from which the results are reported per body pair.
+    bool multi_body() const noexcept;
+
+    /// \brief Rebalance the local patches when one of them dominates the narrowphase
+    ///
+    /// The narrowphase load of a patch is estimated as its number of elements times the number of patch pairs
+    /// it was part of in the previous step. When the largest load exceeds `_threshold` times the mean load, the
+    /// split ranges computed by `set_entity_data` are recut so each patch carries a similar load: hot patches
+    /// are subdivided into several patches with their own bounds and ids, and cold neighbors are merged. The
+    /// number of patches stays `overdecomposition_factor()`.
+    ///
+    /// \param[in] _threshold   the max/mean load ratio that triggers a rebalance, or 0 to disable (the default)
+    void set_patch_rebalance_threshold( double _threshold ) noexcept;
+
+    /// \brief Keep the element-to-patch assignment of the previous step while it is still good enough
+    ///
+    /// With hysteresis enabled, `set_entity_data` only updates the bounds of the existing patches instead of
+    /// splitting the elements again, as long as the number of elements is unchanged, no patch's bounds grew by
+    /// more than `_max_bounds_growth` since its elements were assigned, and the patch load (elements times
+    /// narrowphase pairs of the previous step) stays below `_max_imbalance` times the mean. Patch ids and
+    /// membership then stay the same from step to step.
+    ///
+    /// \param[in] _max_bounds_growth  relative growth of the summed extents of a patch's bounds that triggers
+    ///                                a re-split, or 0 to disable hysteresis (the default)
+    /// \param[in] _max_imbalance      the max/mean load ratio that triggers a re-split, or 0 to ignore the load
+    void set_patch_hysteresis( double _max_bounds_growth, double _max_imbalance = 0.0 ) noexcept;
+
+    /// \brief Write the acceleration state of the last `set_entity_data` on this rank to a local binary file
+    ///
+    /// The state covers the element-to-patch assignment and the per-patch bookkeeping of rebalancing and hysteresis.
+    /// The element data, snapshots and broadphase tree are not saved, they depend on the element positions and are
+    /// recomputed by the next `set_entity_data` and `init_broadphase`.
+    ///
+    /// \param[in] _path  the file to write, which should differ between ranks
+    void save_state( const std::string &_path ) const;
+
+    /// \brief Restore the state written by `save_state`, e.g. after a restart
+    ///
+    /// The next `set_entity_data` with the same number of elements keeps the restored element-to-patch assignment
+    /// instead of splitting the elements again, subject to `set_patch_hysteresis` if enabled. The object must have
+    /// the same overdecomposition factor as the one that saved the state.
+    ///
+    /// \param[in] _path  the file written by `save_state` on this rank
+    /// \throws state_file_exception if the file can't be read, is truncated or corrupt, or doesn't match this object,
+    ///         which is left unchanged
+    void load_state( const std::string &_path );
+
+    /// \brief Let the overdecomposition factor adapt to the measured cost of the collision detection
+    ///
+    /// Every rank times the broadphase, ghosting and narrowphase of this object over `_sample_steps` steps. The
+    /// factor then moves to a neighboring power of two within the bounds if the cost model of
+    /// `choose_overdecomposition` predicts that a step gets cheaper by more than `_min_gain`. Changing the factor
+    /// re-splits the elements and reconstructs the collections of this object, so it only happens when the
+    /// expected gain is worth it.
+    ///
+    /// With this enabled `set_entity_data` is collective, every rank has to call it for every step. It must be set
+    /// identically on every rank.
+    ///
+    /// \param[in] _min_od        the smallest factor, a power of two
+    /// \param[in] _max_od        the largest factor, a power of two, or 0 to disable (the default)
+    /// \param[in] _sample_steps  the number of steps timed before each decision
+    /// \param[in] _min_gain      the relative reduction of the step cost required to change the factor
+    void set_adaptive_overdecomposition( std::size_t _min_od, std::size_t _max_od, std::size_t _sample_steps = 4,
+                                         double _min_gain = 0.1 );
+
+    /// \brief Whether the last `set_entity_data` kept the element-to-patch assignment of the step before
+    bool patch_assignment_kept() const noexcept;
+
+    /// \brief The elements whose local patch changed in the last `set_entity_data`
+    ///
+    /// Only tracked with hysteresis or patch rebalancing enabled, and only when the number of elements did not
+    /// change. Empty when the assignment was kept.
+    span< const patch_membership_change > patch_membership_changes() const noexcept;
 
     void end_phase();
 
@@ -186,6 +445,30 @@ namespace bvh
       } );
     }
 
+    /// \brief Hand results to a callback on the owning rank as soon as they arrive
+    ///
+    /// Unlike `for_each_result` this is not a collective step: every result message is passed to `_on_result`
+    /// as it lands, so processing can start while other narrowphase pairs are still running. `_on_done` is called
+    /// once the current epoch (typically the one pushed by `collision_world::start_iteration`) terminates, after
+    /// which the callback is unregistered. While a callback is registered, results are not stored for
+    /// `for_each_result`.
+    ///
+    /// \tparam ResultType     the type of the results produced by the narrowphase functor
+    /// \param[in] _on_result  callable with a `const ResultType &`
+    /// \param[in] _on_done    callable with no arguments
+    template< typename ResultType, typename F, typename D >
+    void stream_results( F &&_on_result, D &&_on_done )
+    {
+      stream_results_impl(
+        [fun = std::forward< F >( _on_result )]( const narrowphase_result &_res ) mutable {
+          for ( std::size_t i = 0; i < _res.size(); ++i )
+          {
+            fun( *reinterpret_cast< const ResultType * >( _res.at( i ) ) );
+          }
+        },
+        std::forward< D >( _on_done ) );
+    }
+
     span< const patch<> > local_patches() const noexcept;
 
     spdlog::logger &logger() const noexcept;
@@ -196,14 +479,37 @@ namespace bvh
 
     friend class collision_world;
 
+    template< typename T, typename... ViewProp >
+    void set_entity_data_elements( Kokkos::View< const T *, ViewProp... > _data, split_algorithm _algorithm )
+    {
+      update_body_ids( _data );
+      adapt_overdecomposition();
+
+      // Keeping the assignment is a local decision, which the collective global morton split can't skip
+      if ( _algorithm != split_algorithm::global_morton && try_keep_patch_assignment( _data ) )
+        return;
+
+      switch ( _algorithm )
+      {
+        case split_algorithm::geom_axis: set_entity_data_geom_axis( _data ); break;
+        case split_algorithm::ml_geom_axis: set_entity_data_ml_geom_axis( _data ); break;
+        case split_algorithm::clustering: set_entity_data_clustering( _data ); break;
+        case split_algorithm::global_morton: set_entity_data_global_morton( _data ); break;
+      }
+    }
+
     template< typename T, typename...ViewProp >
-    void set_entity_data_with_permutations( Kokkos::View< const T *, ViewProp... > _data, const element_permutations &_splits, ::vt::trace::TraceScopedEvent &&_trace )
+    void set_entity_data_with_permutations( Kokkos::View< const T *, ViewProp... > _data, const element_permutations &_splits, ::vt::trace::TraceScopedEvent &&_trace,
+                                            bool _from_compact = false )
     {
       always_assert( _splits.indices.size() == _data.extent( 0 ), "must have a split index per data element!" );
 
       initialize_split_indices( _splits );
 
-      update_snapshots( _data );
+      if ( _from_compact )
+        update_snapshots_from_compact( _data );
+      else
+        update_snapshots( _data );
 
       set_entity_data_impl( _data.data(), sizeof( T ) );
       std::move( _trace ).end();
@@ -211,11 +517,109 @@ namespace bvh
 
     collision_object( collision_world &_world, std::size_t _idx, std::size_t _overdecomposition );
 
+    /// \brief Create the objgroup of this object. Collective, call within a collective epoch
+    void make_objgroup();
+
+    /// \brief Start constructing the patch and narrowphase collections of this object. Collective
+    ///
+    /// \param[out] _pending  the epochs to wait on until the collections are constructed are appended here
+    void make_collections( std::vector< ::vt::EpochType > &_pending ) const;
+
     /// \brief Implementation for setting the container of data
     ///
     /// \param[in] _data
     /// \param[in] _element_size
-    void set_entity_data_impl( const void *_data, std::size_t _element_size );
+    /// \param[in] _kept_assignment  whether the split indices are the ones of the previous step
+    void set_entity_data_impl( const void *_data, std::size_t _element_size, bool _kept_assignment = false );
+
+    /// \brief Update the existing patches with new data if the hysteresis allows keeping them
+    ///
+    /// \return whether the data was set, otherwise the elements need to be split again
+    template< typename T, typename... ViewProp >
+    bool try_keep_patch_assignment( Kokkos::View< const T *, ViewProp... > _data )
+    {
+      if ( !can_keep_patch_assignment( _data.extent( 0 ) ) )
+        return false;
+
+      update_snapshots( _data );
+      return keep_patch_assignment( _data.data(), sizeof( T ) );
+    }
+
+    /// \brief Split the (unpermuted) snapshots and permute them into patch order
+    ///
+    /// Used when the snapshots are made from something other than an element array, e.g. coordinates and connectivity.
+    void split_snapshots( split_algorithm _algorithm );
+
+    /// \brief Permute the snapshots through the split indices
+    void permute_snapshots();
+
+    /// \brief Compute the permutations of the (unpermuted) snapshots for `split_algorithm::global_morton`
+    void global_morton_permutations( element_permutations &_permutations );
+
+    /// \brief Whether the world is capturing inputs, see `collision_world::start_capture`
+    bool capturing() const noexcept;
+
+    /// \brief Capture the snapshots of the elements
+    ///
+    /// \param[in] _element_size  the size of the narrowphase payload of an element, which differs from `sizeof( T )`
+    ///                           when the elements are projected
+    template< typename T, typename... ViewProp >
+    void capture_entity_data( Kokkos::View< const T *, ViewProp... > _data, split_algorithm _algorithm,
+                              std::size_t _element_size = sizeof( T ) )
+    {
+      // This assumes _data is on host, same as the narrowphase payload
+      std::vector< entity_snapshot > snapshots;
+      snapshots.reserve( _data.extent( 0 ) );
+      for ( std::size_t i = 0; i < _data.extent( 0 ); ++i )
+        snapshots.push_back( make_snapshot( _data( i ), i ) );
+      capture_snapshots( _algorithm, _element_size, snapshots );
+    }
+
+    template< typename T, typename... ViewProp >
+    void update_body_ids( Kokkos::View< const T *, ViewProp... > _data )
+    {
+      std::vector< std::size_t > body_ids;
+      if constexpr ( has_body_id_v< T > )
+      {
+        // This assumes _data is on host, same as the narrowphase payload
+        body_ids.resize( _data.extent( 0 ) );
+        for ( std::size_t i = 0; i < _data.extent( 0 ); ++i )
+          body_ids[i] = static_cast< std::size_t >( detail::get_body_id( _data( i ) ) );
+      }
+      set_body_ids( has_body_id_v< T >, std::move( body_ids ) );
+    }
+
+    /// \brief Change the overdecomposition factor if the phases timed since the last decision call for it
+    ///
+    /// Collective when the adaptive overdecomposition is enabled, a no-op otherwise.
+    void adapt_overdecomposition();
+
+    /// \brief Change the number of local patches and drop everything sized by it. Collective
+    void set_overdecomposition( std::size_t _od );
+
+    /// \brief Set the body of every (original) element, `_multi_body` is false for element types without a body id
+    void set_body_ids( bool _multi_body, std::vector< std::size_t > &&_body_ids );
+
+    /// \brief Debug log of the clustering, out of line so that it follows the library's `BVH_LOG_ACTIVE_LEVEL`
+    void log_clustering( std::size_t _num_elements ) const;
+
+    void capture_snapshots( split_algorithm _algorithm, std::size_t _element_size, span< const entity_snapshot > _snapshots );
+
+    /// \brief Capture the snapshots of the object, which are in patch order, in their original element order
+    void capture_permuted_snapshots( split_algorithm _algorithm, std::size_t _element_size );
+
+    bool can_keep_patch_assignment( std::size_t _num_elements ) const;
+    bool keep_patch_assignment( const void *_data, std::size_t _element_size );
+
+    /// Writes the narrowphase payloads of the elements with the given (original) indices of a patch, in order, to the
+    /// destination. Called once per patch, so the per-element work inlines into the gather
+    using entity_gather_function = std::function< void( span< const std::size_t >, unsigned char * ) >;
+
+    /// \brief Replace the plain copy of each element into the narrowphase payload by a custom gather
+    ///
+    /// \param[in] _unit_size  the number of bytes `_gather` writes per element
+    /// \param[in] _gather     the gather function
+    void set_entity_gather( std::size_t _unit_size, entity_gather_function &&_gather );
 
     void set_all_narrow_patches();
     void set_active_narrow_patches();
@@ -238,7 +642,61 @@ namespace bvh
       auto &ind = get_split_indices_h();
       Kokkos::parallel_for(
         ind.extent( 0 ), KOKKOS_LAMBDA( int _idx ) {
-          snap( ind( _idx ) ) = make_snapshot( _data_view( _idx ), static_cast< std::size_t >( _idx ) );
+          snap( _idx ) = make_snapshot( _data_view( ind( _idx ) ), ind( _idx ) );
+        } );
+    }
+
+    /// \brief Make the snapshot of every element with `_make( i )`, in patch order if `_permuted`
+    template< typename MakeSnapshot >
+    void
+    update_snapshots_with( std::size_t _n, MakeSnapshot _make, bool _permuted )
+    {
+      // No-op if the view is the same size, which is typically the case
+      auto &snap = get_snapshots();
+      Kokkos::resize( Kokkos::WithoutInitializing, snap, _n );
+      if ( _permuted )
+      {
+        auto &ind = get_split_indices_h();
+        Kokkos::parallel_for(
+          _n, KOKKOS_LAMBDA( int _idx ) { snap( _idx ) = _make( ind( _idx ) ); } );
+      } else {
+        Kokkos::parallel_for(
+          _n, KOKKOS_LAMBDA( int _idx ) { snap( _idx ) = _make( static_cast< std::size_t >( _idx ) ); } );
+      }
+    }
+
+    /// \brief Make the compact snapshots of the (unpermuted) elements, see `set_compact_split`
+    template< typename T, typename... ViewProp >
+    void
+    update_compact_snapshots( Kokkos::View< const T *, ViewProp... > _data_view )
+    {
+      always_assert( _data_view.extent( 0 ) <= std::numeric_limits< compact_entity_snapshot::index_type >::max(),
+                     "too many elements for compact snapshots" );
+      auto &snap = get_compact_snapshots();
+      Kokkos::resize( Kokkos::WithoutInitializing, snap, _data_view.extent( 0 ) );
+      Kokkos::parallel_for(
+        _data_view.extent( 0 ), KOKKOS_LAMBDA( int _idx ) {
+          snap( _idx ) = make_compact_snapshot( _data_view( _idx ), static_cast< std::size_t >( _idx ) );
+        } );
+    }
+
+    /// \brief Make the (permuted) snapshots from the compact snapshots of this split, see `set_compact_split`
+    ///
+    /// Only the global id is read from the elements, the bounds and centroid are widened from the compact snapshots.
+    /// The bounds therefore stay rounded outward to float precision, which is conservative.
+    template< typename T, typename... ViewProp >
+    void
+    update_snapshots_from_compact( Kokkos::View< const T *, ViewProp... > _data_view )
+    {
+      auto &snap = get_snapshots();
+      Kokkos::resize( Kokkos::WithoutInitializing, snap, _data_view.extent( 0 ) );
+      const auto &compact = get_compact_snapshots();
+      auto &ind = get_split_indices_h();
+      Kokkos::parallel_for(
+        ind.extent( 0 ), KOKKOS_LAMBDA( int _idx ) {
+          const auto &c = compact( ind( _idx ) );
+          snap( _idx ) = entity_snapshot( element_traits< T >::get_global_id( _data_view( ind( _idx ) ) ), c.kdop(),
+                                          c.centroid(), ind( _idx ) );
         } );
     }
 
@@ -259,8 +717,10 @@ namespace bvh
 
     void for_each_tree_impl( tree_function &&_fun );
     void for_each_result_impl( std::function< void(const narrowphase_result &) > &&_fun );
+    void stream_results_impl( std::function< void( const narrowphase_result & ) > &&_fun, std::function< void() > &&_done );
 
     view< bvh::entity_snapshot * > &get_snapshots();
+    view< bvh::compact_entity_snapshot * > &get_compact_snapshots();
     view< std::size_t * > &get_split_indices();
     view< std::size_t * > &get_splits();
     host_view< std::size_t * > &get_split_indices_h();
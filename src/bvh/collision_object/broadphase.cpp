@@ -37,6 +37,8 @@
 #include "../vt/print.hpp"
 #include "../collision_world/impl.hpp"
 
+#include <cmath>
+
 namespace bvh
 {
   namespace collision_object_impl
@@ -46,6 +48,7 @@ namespace bvh
       struct flag_active_narrowpatch_msg : ::vt::CollectionMessage< broadphase_patch_collection_type >
       {
         collision_object_proxy_type patch_obj;
+        bool count_pair = true;
       };
 
       void flag_active_narrowpatch( broadphase_patch_collection_type *_patch, flag_active_narrowpatch_msg *_msg )
@@ -53,25 +56,78 @@ namespace bvh
         auto &patch_obj = _msg->patch_obj.get()->self;
         auto activate_narrowphase_index_msg = ::vt::makeMessage< active_narrowphase_local_index_msg  >();
         activate_narrowphase_index_msg->idx = _patch->local_idx;
+        activate_narrowphase_index_msg->count_pair = _msg->count_pair;
         patch_obj->get_impl().objgroup[_patch->origin_node].sendMsg<active_narrowphase_local_index_msg, &collision_object_impl::collision_object_holder::insert_active_narrow_local_index >( activate_narrowphase_index_msg );
       }
 
       struct start_broadphase_msg : ::vt::CollectionMessage< broadphase_patch_collection_type >
       {
-        collision_object_proxy_type patch_obj;
-        collision_object_proxy_type tree_obj;
+        collision_object_proxy_type patch_obj;   ///< Object owning the patch being queried
+        collision_object_proxy_type tree_obj;    ///< Object owning the tree being queried against
+        collision_object_proxy_type record_obj;  ///< Object whose narrowphase collection receives the contacts
         vt_index patch_index;
         vt_index local_idx;
         ::vt::NodeType origin_node;
       };
 
+      /// Record a contact between patch `_p` of `_patch_obj` and patch `_q` of `_tree_obj` in the narrowphase collection
+      /// of `_record_obj`, and flag both patches as active for the narrowphase
+      void record_contact( collision_object *_patch_obj, collision_object *_tree_obj, collision_object *_record_obj,
+                           bool _swapped, vt_index _local_idx, ::vt::NodeType _origin_node, std::size_t _p, std::size_t _q )
+      {
+        auto &logger = _patch_obj->broadphase_logger();
+        auto &tok = *_record_obj->get_impl().narrowphase_modification_token;
+        // The narrowphase index is always ordered as seen from the recording object, so when the
+        // recording object supplied the tree the patch and leaf ids have to be swapped
+        auto *other_obj = _swapped ? _patch_obj : _tree_obj;
+
+        collision_object_impl::narrowphase_index idx( static_cast< int >( _swapped ? _q : _p ),
+                                                      static_cast<int>( other_obj->get_impl().collision_idx ),
+                                                      static_cast< int >( _swapped ? _p : _q ) );
+        SPDLOG_LOGGER_TRACE( &logger, "found broadphase contact <{}, {}, {}, {}>",
+                                      _patch_obj->id(), _p, _tree_obj->id(), _q );
+        SPDLOG_LOGGER_TRACE( &logger, "obj={} inserting {} into narrowphase collection", _record_obj->id(), idx );
+        _record_obj->get_impl().narrowphase_collection_proxy[idx].insert( tok );
+        SPDLOG_LOGGER_TRACE( &logger, "obj={} adding {} to active narrowphase indices", _record_obj->id(), idx );
+        _record_obj->get_impl().active_narrowphase_indices.emplace_back( idx );
+        //
+        auto activate_narrowphase_index_msg = ::vt::makeMessage< active_narrowphase_local_index_msg  >();
+        activate_narrowphase_index_msg->idx = _local_idx;
+        SPDLOG_LOGGER_TRACE( &logger, "<send=objgroup({})> obj={} insert_active_narrow_local_index local_idx={}",
+                                      _origin_node, _patch_obj->id(), _local_idx );
+        _patch_obj->get_impl().objgroup[_origin_node].sendMsg< active_narrowphase_local_index_msg, &collision_object_impl::collision_object_holder::insert_active_narrow_local_index >( activate_narrowphase_index_msg );
+        //
+        // Note that the global index `_q` may not be managed by VT on this rank
+        // So we need to send a message to the rank that VT is using to manage `_q`.
+        //
+        auto tree_msg = ::vt::makeMessage< flag_active_narrowpatch_msg  >();
+        tree_msg->patch_obj = _tree_obj->get_impl().objgroup;
+        // A patch colliding with itself is counted once, by the message above, same as in-process
+        tree_msg->count_pair = ( _patch_obj != _tree_obj || _p != _q );
+        SPDLOG_LOGGER_TRACE( &logger, "<send={}> obj={} flag_active_narrowpatch",
+                                      _q, _patch_obj->id() );
+        _tree_obj->get_impl().broadphase_patch_collection_proxy[_q].sendMsg< flag_active_narrowpatch_msg, &flag_active_narrowpatch >( tree_msg );
+      }
+
+      /// Make sure the narrowphase collection of `_record_obj` has an element this step, even without contacts
+      void insert_placeholder( collision_object *_record_obj )
+      {
+        auto &tok = *_record_obj->get_impl().narrowphase_modification_token;
+        collision_object_impl::narrowphase_index tmp_idx( 0, static_cast< int >( _record_obj->get_impl().collision_idx ), 0 );
+        _record_obj->get_impl().narrowphase_collection_proxy[tmp_idx].insert( tok );
+      }
+
       void start_broadphase( broadphase_patch_collection_type *_patch, start_broadphase_msg *_msg )
       {
         auto &patch = _patch->patch;
         auto &patch_obj = _msg->patch_obj.get()->self;
-        auto &tok = *patch_obj->get_impl().narrowphase_modification_token;
-        collision_object_impl::narrowphase_index tmp_idx( 0, static_cast< int >( patch_obj->get_impl().collision_idx ), 0 );
-        patch_obj->get_impl().narrowphase_collection_proxy[tmp_idx].insert( tok );
+        auto &record_obj = _msg->record_obj.get()->self;
+
+        // Object bounds are disjoint, nothing was set up for this pair
+        if ( record_obj->get_impl().broadphase_culled )
+          return;
+
+        insert_placeholder( record_obj );
 
         debug_assert( patch.global_id() != static_cast< broadphase_patch_type::index_type >( -1 ), "patch wasn't initialized" );
 
@@ -81,56 +137,150 @@ namespace bvh
         //
         auto &tree_obj = _msg->tree_obj.get()->self;
         auto &tree = tree_obj->get_impl().tree;
-        int origin_node = _msg->origin_node;
-        auto local_idx = _msg->local_idx;
-        //
-        tmp_idx[1] = static_cast<int>( tree_obj->get_impl().collision_idx );
+        const bool swapped = ( record_obj != patch_obj );
+        // A multi-body object colliding with itself finds every pair of distinct patches from both sides
+        const bool self_pair = ( patch_obj == tree_obj );
         //
 
         auto &logger = patch_obj->broadphase_logger();
-        logger.debug( "(objp={}, size={}) (objq={}, count={}) starting broadphase", patch_obj->id(), patch.size(), tree_obj->id(), tree.count() );
-
-        query_tree( tree, patch, [&_msg, &logger, local_idx, origin_node, &patch_obj, &tree_obj, &tok]( std::size_t _p, std::size_t _q ){
-          collision_object_impl::narrowphase_index idx( static_cast< int >( _p ),
-                                                        static_cast<int>( tree_obj->get_impl().collision_idx ),
-                                                        static_cast< int >( _q ) );
-          logger.trace( "found broadphase contact <{}, {}, {}, {}>",
-                        patch_obj->id(), _p, tree_obj->id(), _q );
-          logger.trace( "obj={} inserting {} into narrowphase collection", patch_obj->id(), idx );
-          patch_obj->get_impl().narrowphase_collection_proxy[idx].insert( tok );
-          logger.trace( "obj={} adding {} to active narrowphase indices", patch_obj->id(), idx );
-          patch_obj->get_impl().active_narrowphase_indices.emplace_back( idx );
-          //
-          auto activate_narrowphase_index_msg = ::vt::makeMessage< active_narrowphase_local_index_msg  >();
-          activate_narrowphase_index_msg->idx = local_idx;
-          logger.trace( "<send=objgroup({})> obj={} insert_active_narrow_local_index local_idx={}",
-                        origin_node, patch_obj->id(), local_idx );
-          patch_obj->get_impl().objgroup[origin_node].sendMsg< active_narrowphase_local_index_msg, &collision_object_impl::collision_object_holder::insert_active_narrow_local_index >( activate_narrowphase_index_msg );
-          //
-          // Note that the global index `_q` may not be managed by VT on this rank
-          // So we need to send a message to the rank that VT is using to manage `_q`.
-          //
-          auto tree_msg = ::vt::makeMessage< flag_active_narrowpatch_msg  >();
-          tree_msg->patch_obj = _msg->tree_obj;
-          logger.trace( "<send={}> obj={} flag_active_narrowpatch",
-                        _q, patch_obj->id() );
-          tree_obj->get_impl().broadphase_patch_collection_proxy[_q].sendMsg< flag_active_narrowpatch_msg, &flag_active_narrowpatch >( tree_msg );
+        SPDLOG_LOGGER_DEBUG( &logger, "(objp={}, size={}) (objq={}, count={}) starting broadphase", patch_obj->id(), patch.size(), tree_obj->id(), tree.count() );
+        auto &patch_impl = patch_obj->get_impl();
+        phase_timer timer( patch_impl.adaptive_overdecomposition(), patch_impl.local_phase_times.broadphase );
+
+        query_tree( tree, patch, [&_msg, swapped, self_pair, &patch_obj, &tree_obj, &record_obj]( std::size_t _p, std::size_t _q ){
+          if ( self_pair && _p > _q )
+            return;
+          record_contact( patch_obj, tree_obj, record_obj, swapped, _msg->local_idx, _msg->origin_node, _p, _q );
+        } );
+      }
+
+      /// Query every local patch of `_patch_obj` against the tree of `_tree_obj` at once, see `world_config::parallel_broadphase`
+      void parallel_broadphase( collision_object *_patch_obj, collision_object *_tree_obj, collision_object *_record_obj )
+      {
+        auto &patch_impl = _patch_obj->get_impl();
+        const auto rank = ::vt::theContext()->getNode();
+        const bool swapped = ( _record_obj != _patch_obj );
+        const bool self_pair = ( _patch_obj == _tree_obj );
+
+        insert_placeholder( _record_obj );
+
+        std::vector< std::vector< std::pair< std::size_t, std::size_t > > > hits;
+        {
+          phase_timer timer( patch_impl.adaptive_overdecomposition(), patch_impl.local_phase_times.broadphase );
+          hits = query_local_patches( patch_impl, _tree_obj->get_impl().tree, self_pair );
+        }
+
+        // Messaging and collection insertion stay on the scheduler thread
+        for ( std::size_t i = 0; i < hits.size(); ++i )
+          for ( auto &&[p, q] : hits[i] )
+            record_contact( _patch_obj, _tree_obj, _record_obj, swapped, vt_index{ i }, rank, p, q );
+      }
+
+      /// Estimated cost of querying every patch of `_patches` against the tree of `_tree`
+      double query_cost( const collision_object::impl &_patches, const collision_object::impl &_tree )
+      {
+        const auto npatches = static_cast< double >( _patches.tree.count() );
+        const auto nleafs = static_cast< double >( _tree.tree.count() );
+
+        return npatches * std::log2( nleafs + 1.0 );
+      }
+    }
+
+    std::vector< std::vector< std::pair< std::size_t, std::size_t > > >
+    query_local_patches( const collision_object::impl &_patch_impl, const tree_type &_tree, bool _self_pair )
+    {
+      const auto &patches = _patch_impl.local_patches;
+      std::vector< std::vector< std::pair< std::size_t, std::size_t > > > hits( patches.size() );
+
+      // Every patch appends to its own buffer, so the queries don't need to synchronize
+      Kokkos::parallel_for( "bvh::query_local_patches",
+                            Kokkos::RangePolicy< Kokkos::DefaultHostExecutionSpace >( 0, patches.size() ),
+                            [&]( std::size_t _i ) {
+        const auto &patch = patches[_i];
+        if ( patch.empty() )
+          return;
+
+        query_tree( _tree, patch, [&]( std::size_t _p, std::size_t _q ) {
+          if ( !_self_pair || _p <= _q )
+            hits[_i].emplace_back( _p, _q );
         } );
+      } );
+      Kokkos::fence();
+
+      return hits;
+    }
+
+    bool query_other_patches( const collision_object::impl &_this, const collision_object::impl &_other,
+                              broadphase_orientation _orientation )
+    {
+      switch ( _orientation )
+      {
+        case broadphase_orientation::this_patches: return false;
+        case broadphase_orientation::other_patches: return true;
+        case broadphase_orientation::automatic: break;
+      }
+
+      // Only one of the objects has a current tree, so that one has to be queried
+      if ( _this.build_trees != _other.build_trees )
+        return _this.build_trees;
+
+      if ( !_this.build_trees )
+        return false;
+
+      return query_cost( _other, _this ) < query_cost( _this, _other );
+    }
+
+    void collision_object_holder::broadphase( broadphase_msg *_msg )
+    {
+      auto &this_impl = self->get_impl();
+
+      if ( this_impl.broadphase_culled )
+        return;
+
+      auto &other = *_msg->other_obj.get()->self;
+      auto &other_impl = other.get_impl();
+      auto &logger = self->broadphase_logger();
+
+      const bool swapped = query_other_patches( this_impl, other_impl, _msg->orientation );
+      auto &patch_impl = swapped ? other_impl : this_impl;
+      auto &tree_impl = swapped ? this_impl : other_impl;
+
+      const auto rank = ::vt::theContext()->getNode();
+      const auto od_factor = patch_impl.overdecomposition;
+      const std::size_t offset = rank * od_factor;
+
+      SPDLOG_LOGGER_DEBUG( &logger, "obj={} target_obj={} querying patches of obj={} against tree of obj={}", self->id(), other.id(),
+                                    patch_impl.collision_idx, tree_impl.collision_idx );
+
+      // The local patches are current on this rank, so they can be queried here instead of in their collection elements
+      if ( get_impl( *this_impl.world ).parallel_broadphase )
+      {
+        parallel_broadphase( swapped ? &other : self, swapped ? self : &other, self );
+        return;
+      }
+
+      for ( std::size_t i = 0; i < od_factor; ++i )
+      {
+        auto msg = ::vt::makeMessage< start_broadphase_msg >();
+        msg->patch_obj = patch_impl.objgroup;
+        msg->tree_obj = tree_impl.objgroup;
+        msg->record_obj = this_impl.objgroup;
+        msg->patch_index = vt_index{ i + offset };
+        msg->local_idx = vt_index{ i };
+        msg->origin_node = rank;
+        SPDLOG_LOGGER_TRACE( &logger, "<send={}> obj={} start broadphase", msg->patch_index, patch_impl.collision_idx );
+        patch_impl.broadphase_patch_collection_proxy[vt_index{ i + offset }]
+          .sendMsg< start_broadphase_msg, &start_broadphase >( msg );
       }
     }
 
-    pending_send broadphase( vt_index _global_idx, vt_index _local_idx, int _origin_node,
-                             broadphase_patch_collection_proxy _this_patches,
-                             collision_object_proxy_type _this_obj,
-                             collision_object_proxy_type _other_obj )
+    pending_send broadphase( [[maybe_unused]] vt_index _local_idx, collision_object_proxy_type _this_obj,
+                             collision_object_proxy_type _other_obj, broadphase_orientation _orientation )
     {
-      auto msg = ::vt::makeMessage< start_broadphase_msg >();
-      msg->patch_obj = _this_obj;
-      msg->tree_obj = _other_obj;
-      msg->patch_index = _global_idx;
-      msg->local_idx = _local_idx;
-      msg->origin_node = _origin_node;
-      return _this_patches[_global_idx].sendMsg< start_broadphase_msg, &start_broadphase >( msg );
+      auto msg = ::vt::makeMessage< broadphase_msg >();
+      msg->other_obj = _other_obj;
+      msg->orientation = _orientation;
+      return _this_obj[::vt::theContext()->getNode()].sendMsg< broadphase_msg, &collision_object_holder::broadphase >( msg );
     }
   }
 }
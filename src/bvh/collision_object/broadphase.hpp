@@ -33,16 +33,39 @@
 #ifndef INC_BVH_COLLISION_OBJECT_BROADPHASE_HPP
 #define INC_BVH_COLLISION_OBJECT_BROADPHASE_HPP
 
+#include <utility>
+#include <vector>
 #include "types.hpp"
+#include "../collision_object.hpp"
 
 namespace bvh
 {
   namespace collision_object_impl
   {
-    pending_send broadphase( vt_index _global_idx, vt_index _local_idx, int _origin_node,
-                             broadphase_patch_collection_proxy _this_patches,
+    /// \brief Query the patches of one object against the tree of the other
+    ///
+    /// Which object supplies the patches is decided once both trees are known, see `broadphase_orientation`.
+    /// Contacts are always recorded in the narrowphase collection of `_this_obj`.
+    pending_send broadphase( vt_index _local_idx,
                              collision_object_proxy_type _this_obj,
-                             collision_object_proxy_type _other_obj);
+                             collision_object_proxy_type _other_obj,
+                             broadphase_orientation _orientation );
+
+    /// \brief Query every non-empty local patch against a tree in a Kokkos `parallel_for` over the patches on the host
+    ///
+    /// \param[in] _patch_impl  the object supplying the local patches
+    /// \param[in] _tree        the tree to query
+    /// \param[in] _self_pair   whether the tree is the one of the patches' object, then each pair of patches is only
+    ///                         returned once
+    /// \return the (patch id, tree leaf id) pairs found for each local patch, in the order of the serial queries
+    std::vector< std::vector< std::pair< std::size_t, std::size_t > > >
+    query_local_patches( const collision_object::impl &_patch_impl, const tree_type &_tree, bool _self_pair );
+
+    /// \brief Whether the patches of `_other` should be queried against the tree of `_this`
+    ///
+    /// This only depends on data that is identical on every rank, so every rank picks the same orientation.
+    bool query_other_patches( const collision_object::impl &_this, const collision_object::impl &_other,
+                              broadphase_orientation _orientation );
   }
 }
 
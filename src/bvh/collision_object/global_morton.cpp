@@ -0,0 +1,214 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "global_morton.hpp"
+#include "../vt/helpers.hpp"
+#include "../split/morton_splitters.hpp"
+#include "impl.hpp"
+#include "types.hpp"
+
+#include <vt/collective/reduce/operators/functors/plus_op.h>
+
+namespace bvh
+{
+  namespace collision_object_impl
+  {
+    namespace
+    {
+      struct global_morton_bounds_msg : ::vt::Message
+      {
+        using MessageParentType = ::vt::Message;
+        vt_msg_serialize_required();
+
+        kdop_type value;
+
+        template< typename Serializer >
+        void serialize( Serializer &_s )
+        {
+          MessageParentType::serialize( _s );
+          _s | value;
+        }
+      };
+
+      struct global_morton_splitters_msg : ::vt::Message
+      {
+        using MessageParentType = ::vt::Message;
+        vt_msg_serialize_required();
+
+        std::vector< morton32_t > value;
+
+        template< typename Serializer >
+        void serialize( Serializer &_s )
+        {
+          MessageParentType::serialize( _s );
+          _s | value;
+        }
+      };
+
+      class bounds_reduction
+      {
+      public:
+
+        bounds_reduction() = default;
+
+        bounds_reduction( collision_object_proxy_type _collision_object, const kdop_type &_bounds )
+          : m_collision_object_proxy( _collision_object ),
+            m_bounds( _bounds )
+        {}
+
+        bounds_reduction &operator+=( const bounds_reduction &_other )
+        {
+          debug_assert( m_collision_object_proxy.getProxy() == _other.m_collision_object_proxy.getProxy(), "collision objects must match" );
+          m_bounds.union_with( _other.m_bounds );
+          return *this;
+        }
+
+        friend bounds_reduction operator+( bounds_reduction _lhs, const bounds_reduction &_rhs )
+        {
+          return _lhs += _rhs;
+        }
+
+        collision_object_proxy_type collision_object_proxy() const noexcept { return m_collision_object_proxy; }
+
+        const kdop_type &bounds() const noexcept { return m_bounds; }
+
+        template< typename Serializer >
+        void serialize( Serializer &_s )
+        {
+          _s | m_collision_object_proxy | m_bounds;
+        }
+
+      private:
+
+        collision_object_proxy_type m_collision_object_proxy;
+        kdop_type m_bounds;
+      };
+
+      class samples_reduction
+      {
+      public:
+
+        samples_reduction() = default;
+
+        samples_reduction( collision_object_proxy_type _collision_object, const std::vector< morton32_t > &_samples,
+                           std::size_t _num_ranges )
+          : m_collision_object_proxy( _collision_object ),
+            m_num_ranges( _num_ranges )
+        {
+          m_samples.vec.assign( _samples.begin(), _samples.end() );
+        }
+
+        samples_reduction &operator+=( const samples_reduction &_other )
+        {
+          debug_assert( m_collision_object_proxy.getProxy() == _other.m_collision_object_proxy.getProxy(), "collision objects must match" );
+          debug_assert( m_num_ranges == _other.m_num_ranges, "number of ranges must match" );
+          m_samples += _other.m_samples;
+          return *this;
+        }
+
+        friend samples_reduction operator+( samples_reduction _lhs, const samples_reduction &_rhs )
+        {
+          return _lhs += _rhs;
+        }
+
+        collision_object_proxy_type collision_object_proxy() const noexcept { return m_collision_object_proxy; }
+
+        span< const morton32_t > samples() const noexcept { return m_samples.vec; }
+
+        std::size_t num_ranges() const noexcept { return m_num_ranges; }
+
+        template< typename Serializer >
+        void serialize( Serializer &_s )
+        {
+          _s | m_collision_object_proxy | m_samples | m_num_ranges;
+        }
+
+      private:
+
+        collision_object_proxy_type m_collision_object_proxy;
+        vt::reducable_vector< morton32_t > m_samples;
+        std::size_t m_num_ranges = 0;
+      };
+
+      void global_morton_bounds_reduce( const bounds_reduction &_reduc )
+      {
+        auto msg = ::vt::makeMessage< global_morton_bounds_msg >();
+        msg->value = _reduc.bounds();
+
+        _reduc.collision_object_proxy().broadcastMsg< global_morton_bounds_msg, &collision_object_holder::receive_reduce_result< global_morton_bounds_msg > >( msg );
+      }
+
+      void global_morton_splitters_reduce( const samples_reduction &_reduc )
+      {
+        const auto samples = _reduc.samples();
+
+        auto msg = ::vt::makeMessage< global_morton_splitters_msg >();
+        msg->value = choose_splitters( std::vector< morton32_t >( samples.begin(), samples.end() ), _reduc.num_ranges() );
+
+        _reduc.collision_object_proxy().broadcastMsg< global_morton_splitters_msg, &collision_object_holder::receive_reduce_result< global_morton_splitters_msg > >( msg );
+      }
+    }
+
+    kdop_type reduce_global_morton_bounds( collision_object_proxy_type _col_obj, const kdop_type &_local_bounds )
+    {
+      // The root only broadcasts once every rank contributed, so the result can't arrive before it points here
+      kdop_type ret;
+      auto *holder = _col_obj.get();
+      holder->reduce_result = &ret;
+
+      ::vt::runInEpochCollective( "collision_object.global_morton_bounds", [&]() {
+        auto r = ::vt::theCollective()->global();
+        r->reduce< global_morton_bounds_reduce, ::vt::collective::PlusOp >( ::vt::Node{ 0 }, bounds_reduction{ _col_obj, _local_bounds } );
+      } );
+
+      holder->reduce_result = nullptr;
+      return ret;
+    }
+
+    std::vector< morton32_t > reduce_global_morton_splitters( collision_object_proxy_type _col_obj,
+                                                              const std::vector< morton32_t > &_local_samples,
+                                                              std::size_t _num_ranges )
+    {
+      std::vector< morton32_t > ret;
+      auto *holder = _col_obj.get();
+      holder->reduce_result = &ret;
+
+      ::vt::runInEpochCollective( "collision_object.global_morton_splitters", [&]() {
+        auto r = ::vt::theCollective()->global();
+        r->reduce< global_morton_splitters_reduce, ::vt::collective::PlusOp >( ::vt::Node{ 0 }, samples_reduction{ _col_obj, _local_samples, _num_ranges } );
+      } );
+
+      holder->reduce_result = nullptr;
+      return ret;
+    }
+  }
+}
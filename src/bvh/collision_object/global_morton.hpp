@@ -0,0 +1,67 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef INC_BVH_COLLISION_OBJECT_GLOBAL_MORTON_HPP
+#define INC_BVH_COLLISION_OBJECT_GLOBAL_MORTON_HPP
+
+#include <vector>
+#include "types.hpp"
+#include "../hash.hpp"
+
+namespace bvh
+{
+  namespace collision_object_impl
+  {
+    /// \brief Reduce the bounds of the elements of every rank
+    ///
+    /// Collective, blocks until every rank of the collision object contributed its bounds.
+    ///
+    /// \param[in] _col_obj       the objgroup of the collision object
+    /// \param[in] _local_bounds  the bounds of the elements on this rank
+    /// \return                   the union of the bounds of every rank
+    kdop_type reduce_global_morton_bounds( collision_object_proxy_type _col_obj, const kdop_type &_local_bounds );
+
+    /// \brief Gather the morton key samples of every rank and choose the splitters of the global key ranges
+    ///
+    /// Collective, blocks until every rank of the collision object contributed its samples.
+    ///
+    /// \param[in] _col_obj        the objgroup of the collision object
+    /// \param[in] _local_samples  samples of the sorted morton keys on this rank
+    /// \param[in] _num_ranges     the number of global key ranges, i.e. the number of global patches
+    /// \return                    the splitters, see `choose_splitters`
+    std::vector< morton32_t > reduce_global_morton_splitters( collision_object_proxy_type _col_obj,
+                                                              const std::vector< morton32_t > &_local_samples,
+                                                              std::size_t _num_ranges );
+  }
+}
+
+#endif  // INC_BVH_COLLISION_OBJECT_GLOBAL_MORTON_HPP
@@ -33,6 +33,7 @@
 #include "impl.hpp"
 #include "narrowphase.hpp"
 #include <vt/messaging/envelope/envelope_extended_util.h>
+#include <array>
 
 namespace bvh
 {
@@ -51,6 +52,23 @@ namespace bvh
 
   namespace collision_object_impl
   {
+    namespace
+    {
+      /// Results for this rank are stored right away instead of being sent to ourselves
+      void send_result( collision_object &_obj, ::vt::NodeType _node, narrowphase_result &&_result )
+      {
+        auto &impl = _obj.get_impl();
+        if ( _node == ::vt::theContext()->getNode() )
+        {
+          impl.store_result( std::move( _result ) );
+          return;
+        }
+
+        auto msg = ::vt::makeMessage< result_msg >();
+        msg->result = std::move( _result );
+        impl.objgroup[_node].sendMsg< result_msg, &collision_object_impl::collision_object_holder::set_result >( msg );
+      }
+    }
 
     //
     // Define member functions for the class 'collision_object_impl::collision_object_holder'
@@ -59,7 +77,10 @@ namespace bvh
 
     void collision_object_holder::insert_active_narrow_local_index( active_narrowphase_local_index_msg *_msg )
     {
-      self->get_impl().active_narrowphase_local_index.insert( _msg->idx.x() );
+      auto &impl = self->get_impl();
+      impl.active_narrowphase_local_index[_msg->idx.x()] = true;
+      if ( _msg->count_pair )
+        ++impl.patch_pair_counts[_msg->idx.x()];
     }
 
     void collision_object_holder::setup_narrowphase( [[maybe_unused]] setup_narrowphase_msg *_msg )
@@ -71,12 +92,21 @@ namespace bvh
       const std::size_t od_offset = rank * od_factor;
       auto &patches = impl.narrowphase_patch_collection_proxy;
 
-      logger.debug( "obj={}, setting up {} narrowphase patches marked as ready to activate", self->id(),
-                    impl.active_narrowphase_indices.size() );
-      for ( const auto idx : impl.active_narrowphase_local_index )
+      SPDLOG_LOGGER_DEBUG( &logger, "obj={}, setting up {} narrowphase patches marked as ready to activate", self->id(),
+                                    impl.active_narrowphase_indices.size() );
+      phase_timer timer( impl.adaptive_overdecomposition(), impl.local_phase_times.ghosting );
+      for ( std::size_t idx = 0; idx < impl.active_narrowphase_local_index.size(); ++idx )
       {
+        if ( !impl.active_narrowphase_local_index[idx] )
+          continue;
+
+        // Copied for an earlier pair in this iteration, the data hasn't changed
+        if ( impl.sent_patch_generation[idx] == impl.ghost_generation )
+          continue;
+        impl.sent_patch_generation[idx] = impl.ghost_generation;
+
         auto send_msg = impl.prepare_local_patch_for_sending( idx, rank );
-        logger.trace( "<send=idx({})> obj={} narrowphase_patch_copy", od_offset + idx, self->id() );
+        SPDLOG_LOGGER_TRACE( &logger, "<send=idx({})> obj={} narrowphase_patch_copy", od_offset + idx, self->id() );
         patches[od_offset + idx].sendMsg< narrowphase_patch_msg, &collision_object_impl::narrowphase_patch_copy >(
           send_msg );
       }
@@ -87,12 +117,15 @@ namespace bvh
       auto &logger = self->narrowphase_logger();
       auto &impl = self->get_impl();
 
-      logger.debug( "obj={}, activating {} narrowphase patches", self->id(), impl.active_narrowphase_indices.size() );
+      if ( impl.broadphase_culled )
+        return;
+
+      SPDLOG_LOGGER_DEBUG( &logger, "obj={}, activating {} narrowphase patches", self->id(), impl.active_narrowphase_indices.size() );
       for ( auto &&idx : impl.active_narrowphase_indices )
       {
         auto msg = ::vt::makeMessage< activate_narrowphase_msg >();
         msg->this_obj = self->get_impl().objgroup;
-        logger.trace( "<send={}> obj={} activate_narrowphase", idx, self->id() );
+        SPDLOG_LOGGER_TRACE( &logger, "<send={}> obj={} activate_narrowphase", idx, self->id() );
         impl.narrowphase_collection_proxy[idx]
           .sendMsg< activate_narrowphase_msg, &collision_object_impl::activate_narrowphase >( msg.get() );
       }
@@ -102,32 +135,29 @@ namespace bvh
     {
       auto &logger = self->narrowphase_logger();
       auto &impl = self->get_impl();
+
+      if ( impl.broadphase_culled )
+        return;
+
       for ( auto &&idx : impl.active_narrowphase_indices )
       {
         auto msg = ::vt::makeMessage< start_ghosting_msg >();
         msg->this_obj = _msg->this_obj;
         msg->other_obj = _msg->other_obj;
-        logger.trace( "<send={}> objp={}, objq={} start_ghosting", idx, _msg->this_obj.get()->self->id(),
-                      _msg->other_obj.get()->self->id() );
+        SPDLOG_LOGGER_TRACE( &logger, "<send={}> objp={}, objq={} start_ghosting", idx, _msg->this_obj.get()->self->id(),
+                                      _msg->other_obj.get()->self->id() );
         impl.narrowphase_collection_proxy[idx].sendMsg< start_ghosting_msg, &collision_object_impl::start_ghosting >(
           msg.get() );
       }
     }
 
-    void collision_object_holder::start_narrowphase( [[maybe_unused]] start_narrowphase_msg *_msg )
-    {
-      auto &impl = self->get_impl();
-      for ( auto &&idx : impl.active_narrowphase_indices )
-      {
-        auto msg = ::vt::makeMessage< start_narrowphase_msg >();
-        impl.narrowphase_collection_proxy[idx]
-          .sendMsg< start_narrowphase_msg, &collision_object_impl::start_narrowphase >( msg.get() );
-      }
-    }
-
     void collision_object_holder::clear_narrowphase( [[maybe_unused]] clear_narrowphase_msg *_msg )
     {
       auto &impl = self->get_impl();
+
+      if ( impl.broadphase_culled )
+        return;
+
       for ( auto &&idx : impl.active_narrowphase_indices )
       {
         auto msg = ::vt::makeMessage< clear_narrowphase_msg >();
@@ -138,6 +168,9 @@ namespace bvh
 
     void collision_object_holder::begin_narrowphase_modification( messages::modify_msg * )
     {
+      if ( self->get_impl().broadphase_culled )
+        return;
+
       ::vt::theMsg()->pushEpoch( ::vt::term::any_epoch_sentinel );
       self->get_impl().narrowphase_modification_token
         = self->get_impl().narrowphase_collection_proxy.beginModification( "broadphase contact insertion" );
@@ -146,27 +179,191 @@ namespace bvh
 
     void collision_object_holder::finish_narrowphase_modification( messages::modify_msg * )
     {
+      if ( self->get_impl().broadphase_culled )
+        return;
+
       self->get_impl().narrowphase_collection_proxy.finishModification(
         std::move( *self->get_impl().narrowphase_modification_token ) );
       self->get_impl().narrowphase_modification_token = {};
     }
 
+    void collision_object_holder::check_broadphase_bounds( check_bounds_msg *_msg )
+    {
+      auto &impl = self->get_impl();
+      const auto &other = *_msg->other_obj.get()->self;
+      const auto &other_impl = other.get_impl();
+
+      // The global bounds are broadcast with the tree, so every rank makes the same decision here.
+      // The bounds are only current if both objects rebuilt their trees this step
+      impl.broadphase_culled = impl.build_trees && other_impl.build_trees
+                               && !overlap( impl.global_bounds, other_impl.global_bounds );
+
+      SPDLOG_LOGGER_DEBUG( &self->broadphase_logger(), "obj={} target_obj={} global bounds {} and {} {}", self->id(), other.id(),
+                                                       impl.global_bounds, other_impl.global_bounds,
+                                                       impl.broadphase_culled ? "are disjoint, culling pair" : "overlap" );
+    }
+
     void collision_object_holder::cache_patch( ghost_msg *_msg )
     {
       auto &impl = self->get_impl();
       auto &logger = self->narrowphase_logger();
-      logger.debug( "obj={} caching patch idx {}", impl.collision_idx, _msg->idx );
+      SPDLOG_LOGGER_DEBUG( &logger, "obj={} caching patch idx {}", impl.collision_idx, _msg->idx );
+
+      auto [ent, inserted] = impl.cache_entry( _msg->idx );
+
+      {
+        phase_timer timer( impl.adaptive_overdecomposition(), impl.local_phase_times.ghosting );
+        ent.meta = _msg->meta;
+        ent.origin_node = _msg->origin_node;
+        ent.patch_data = std::move( _msg->patch_data );
+        if ( !_msg->tree_data.empty() )
+          ent.element_tree = std::move( *::checkpoint::deserialize< tree_type >(
+            reinterpret_cast< char * >( _msg->tree_data.data() ) ) );
+        else
+          ent.element_tree.reset();
+      }
+
+      // Run the narrowphase tasks that were only waiting on this patch
+      if ( inserted )
+        get_impl( *impl.world ).narrowphase_scheduler.payload_ready( { impl.collision_idx, _msg->idx.x() } );
+    }
+
+    void collision_object_holder::run_narrowphase_batches( narrowphase_batches_msg *_msg )
+    {
+      collision_object_impl::run_narrowphase_batches( *self, *_msg->other_obj.get()->self );
+    }
+
+    void run_narrowphase_batches( collision_object &_this_obj, collision_object &_other_obj )
+    {
+      auto &impl = _this_obj.get_impl();
+      auto &logger = _this_obj.narrowphase_logger();
+
+      if ( impl.broadphase_culled )
+        return;
+
+      auto &other_impl = _other_obj.get_impl();
+      auto &world_impl = get_impl( *impl.world );
+      const auto other_id = other_impl.collision_idx;
+      phase_timer timer( impl.adaptive_overdecomposition(), impl.local_phase_times.narrowphase );
+
+      auto beg = impl.narrowphase_batches.lower_bound( { other_id, 0 } );
+      auto end = impl.narrowphase_batches.lower_bound( { other_id + 1, 0 } );
+
+      std::vector< ::bvh::detail::narrowphase_batch_partner > partners;
+      std::vector< ::vt::NodeType > partner_nodes;
+      for ( auto it = beg; it != end; ++it )
+      {
+        const auto this_index = vt_index{ it->first.second };
+        const auto &this_cache = *impl.cached_patch( this_index );
+
+        partners.clear();
+        partner_nodes.clear();
+        for ( auto &&e : it->second )
+        {
+          const auto &other_cache = *other_impl.cached_patch( e.other_index );
+          partners.push_back( ::bvh::detail::narrowphase_batch_partner{
+            &other_cache.meta, other_cache.patch_data.data(), other_cache.patch_data.size(),
+            span< const std::pair< std::size_t, std::size_t > >( e.element_candidates.data(), e.element_candidates.size() ) } );
+          partner_nodes.push_back( other_cache.origin_node );
+        }
+
+        SPDLOG_LOGGER_DEBUG( &logger, "obj={} running batched narrowphase of patch {} with {} partners of obj={}", _this_obj.id(),
+                                      this_index.x(), partners.size(), other_id );
+
+        narrowphase_batch_result r;
+        {
+          ::vt::trace::TraceScopedEvent scope( world_impl.bvh_impl_functor_ );
+          r = world_impl.batch_functor( _this_obj, this_cache.meta, this_cache.patch_data.data(), this_cache.patch_data.size(),
+                                        _other_obj, span< const ::bvh::detail::narrowphase_batch_partner >( partners.data(), partners.size() ) );
+        }
+
+        BVH_ASSERT_ALWAYS( r.partners.empty() || r.partners.size() == partners.size(), logger,
+                           "batched narrowphase returned {} partner results for {} partners", r.partners.size(),
+                           partners.size() );
+
+        if ( r.primary.size() > 0 )
+          send_result( _this_obj, this_cache.origin_node, std::move( r.primary ) );
 
-      auto &ent = impl.narrowphase_patch_cache[_msg->idx];
+        for ( std::size_t i = 0; i < r.partners.size(); ++i )
+        {
+          if ( r.partners[i].size() == 0 )
+            continue;
+          send_result( _this_obj, partner_nodes[i], std::move( r.partners[i] ) );
+        }
+      }
+
+      impl.narrowphase_batches.erase( beg, end );
+    }
 
-      ent.meta = _msg->meta;
-      ent.origin_node = _msg->origin_node;
-      ent.patch_data = _msg->patch_data;
+    void collision_object_holder::run_queued_narrowphase( narrowphase_queue_msg *_msg )
+    {
+      collision_object_impl::run_queued_narrowphase( *self, *_msg->other_obj.get()->self );
+    }
+
+    void run_queued_narrowphase( collision_object &_this_obj, collision_object &_other_obj )
+    {
+      auto &impl = _this_obj.get_impl();
+      auto &logger = _this_obj.narrowphase_logger();
+
+      if ( impl.broadphase_culled )
+        return;
+
+      auto &other_impl = _other_obj.get_impl();
+      auto &world_impl = get_impl( *impl.world );
+      auto it = impl.narrowphase_queue.find( other_impl.collision_idx );
+      if ( it == impl.narrowphase_queue.end() || !world_impl.functor )
+        return;
+
+      const auto &pairs = it->second;
+      phase_timer timer( impl.adaptive_overdecomposition(), impl.local_phase_times.narrowphase );
+      SPDLOG_LOGGER_DEBUG( &logger, "obj={} running {} narrowphase pairs with obj={} in parallel", _this_obj.id(),
+                                    pairs.size(), other_impl.collision_idx );
+
+      // Every pair writes to its own results, so the functor calls don't need to synchronize
+      std::vector< narrowphase_result_pair > results( pairs.size() );
+      {
+        ::vt::trace::TraceScopedEvent scope( world_impl.bvh_impl_functor_ );
+        Kokkos::parallel_for( "bvh::narrowphase", Kokkos::RangePolicy< Kokkos::DefaultHostExecutionSpace >( 0, pairs.size() ),
+                              [&]( std::size_t _i ) {
+          const auto &e = pairs[_i];
+          const auto &this_cache = *impl.cached_patch( e.this_index );
+          const auto &other_cache = *other_impl.cached_patch( e.other_index );
+          results[_i] = world_impl.functor( _this_obj, this_cache.meta, e.this_index.x(), this_cache.patch_data.data(),
+                                            this_cache.patch_data.size(), _other_obj, other_cache.meta, e.other_index.x(),
+                                            other_cache.patch_data.data(), other_cache.patch_data.size(),
+                                            span< const std::pair< std::size_t, std::size_t > >( e.element_candidates.data(),
+                                                                                                 e.element_candidates.size() ) );
+        } );
+        Kokkos::fence();
+      }
+
+      // Merge the results per destination so each rank gets a single result message
+      std::map< ::vt::NodeType, narrowphase_result > merged;
+      auto merge = [&merged]( ::vt::NodeType _node, narrowphase_result &_res ) {
+        if ( _res.size() == 0 )
+          return;
+        auto &m = merged.try_emplace( _node, _res.stride() ).first->second;
+        debug_assert( m.stride() == _res.stride(), "narrowphase results must have the same type" );
+        m.append_data( _res.data(), _res.size() );
+      };
+      for ( std::size_t i = 0; i < pairs.size(); ++i )
+      {
+        merge( impl.cached_patch( pairs[i].this_index )->origin_node, results[i].a );
+        merge( other_impl.cached_patch( pairs[i].other_index )->origin_node, results[i].b );
+      }
+
+      for ( auto &&[node, res] : merged )
+      {
+        SPDLOG_LOGGER_TRACE( &logger, "<send={}> obj={} {} merged results", node, _this_obj.id(), res.size() );
+        send_result( _this_obj, node, std::move( res ) );
+      }
+
+      impl.narrowphase_queue.erase( it );
     }
 
     void collision_object_holder::set_result( result_msg *_msg )
     {
-      self->get_impl().local_results.emplace_back( _msg->result );
+      self->get_impl().store_result( std::move( _msg->result ) );
     }
 
     void activate_narrowphase( collision_object_impl::narrowphase_collection_type *_narrow, activate_narrowphase_msg *_msg )
@@ -174,7 +371,7 @@ namespace bvh
       const auto &this_obj = *_msg->this_obj.get()->self;
       auto &logger = this_obj.narrowphase_logger();
       auto idx = _narrow->getIndex();
-      logger.trace( "marking <{}, {}, {}, {}> as active (epoch={:x})", this_obj.id(), idx[0], idx[1], idx[2], ::vt::envelopeGetEpoch( _msg->env ) );
+      SPDLOG_LOGGER_TRACE( &logger, "marking <{}, {}, {}, {}> as active (epoch={:x})", this_obj.id(), idx[0], idx[1], idx[2], ::vt::envelopeGetEpoch( _msg->env ) );
       _narrow->active = true;
     }
 
@@ -194,12 +391,30 @@ namespace bvh
         auto &logger = obj->narrowphase_logger();
         // Find destination node for the narrowphase collection element
         auto dst = _msg->dest_node;
-        logger.debug( "obj={} requesting ghost for index {} to node {}", obj->id(), _patch->getIndex(), dst );
+        SPDLOG_LOGGER_DEBUG( &logger, "obj={} requesting ghost for index {} to node {}", obj->id(), _patch->getIndex(), dst );
 
-        // Build up ghost_destination list/group. In ghosting step,
-        // this element will be transferred to every node in ghost_destination.
-        // Then it will be cached when narrowphase is executed
-        _patch->ghost_destinations.emplace( dst );
+        debug_assert( _patch->generation == obj->get_impl().ghost_generation,
+                      "ghost requested for a patch that was not copied this iteration" );
+
+        // Already cached on (or on its way to) that node by an earlier pair in this iteration
+        if ( !_patch->mark_delivered( dst ) )
+        {
+          SPDLOG_LOGGER_TRACE( &logger, "obj={} index {} already delivered to {}", obj->id(), _patch->getIndex(), dst );
+          return;
+        }
+
+        // Send right away, the narrowphase on the destination starts as soon as both patches of a pair arrived
+        SPDLOG_LOGGER_DEBUG( &logger, "<send={}> obj={} sending ghost for idx {}", dst, obj->id(), _patch->getIndex() );
+        auto &obj_impl = obj->get_impl();
+        phase_timer timer( obj_impl.adaptive_overdecomposition(), obj_impl.local_phase_times.ghosting );
+        auto msg = ::vt::makeMessage< ghost_msg >();
+        msg->meta = _patch->patch_meta;
+        msg->patch_data = _patch->bytes;
+        msg->tree_data = _patch->tree_bytes;
+        msg->origin_node = _patch->origin_node;
+        msg->idx = _patch->getIndex();
+
+        _patch->collision_object[dst].sendMsg< ghost_msg, &collision_object_impl::collision_object_holder::cache_patch >( msg );
       }
 
     }  // namespace detail
@@ -215,136 +430,227 @@ namespace bvh
       // from earlier iterations
       if ( !_narrow->active )
       {
-        logger.trace( "skipping <{}, {}, {}, {}> -- not active", this_obj->id(), idx[0], idx[1], idx[2] );
+        SPDLOG_LOGGER_TRACE( &logger, "skipping <{}, {}, {}, {}> -- not active", this_obj->id(), idx[0], idx[1], idx[2] );
         return;
       }
 
       // Only run if we are looking at the right "other obj"
       if ( other_obj->get_impl().collision_idx != static_cast< std::size_t >( idx.y() ) )
       {
-        logger.trace( "skipping <{}, {}, {}, {}> -- mismatched index", this_obj->id(), idx[0], idx[1], idx[2] );
+        SPDLOG_LOGGER_TRACE( &logger, "skipping <{}, {}, {}, {}> -- mismatched index", this_obj->id(), idx[0], idx[1], idx[2] );
         return;
       }
 
-      // Ignore self collisions (this will usually be caught by the above condition)
-      if ( this_obj->get_impl().collision_idx == static_cast< std::size_t >( idx.y() ) )
+      // Ignore self collisions (this will usually be caught by the above condition), unless the bodies of a
+      // multi-body object are colliding with each other
+      const bool self_pair = ( this_obj->get_impl().collision_idx == static_cast< std::size_t >( idx.y() ) );
+      if ( self_pair && !this_obj->get_impl().multi_body )
       {
-        logger.trace( "{}: skipping <{}, {}, {}, {}> -- self collision", this_obj->id(), idx[0], idx[1], idx[2] );
+        SPDLOG_LOGGER_TRACE( &logger, "{}: skipping <{}, {}, {}, {}> -- self collision", this_obj->id(), idx[0], idx[1], idx[2] );
         return;
       }
 
       _narrow->this_proxy = _msg->this_obj;
       _narrow->other_proxy = _msg->other_obj;
 
-      logger.debug( "start ghosting <{}, {}, {}, {}>", this_obj->id(), idx[0], idx[1], idx[2] );
+      SPDLOG_LOGGER_DEBUG( &logger, "start ghosting <{}, {}, {}, {}>", this_obj->id(), idx[0], idx[1], idx[2] );
 
-      auto rank = ::vt::theContext()->getNode();
-      // Send ghost request to this obj
-      auto msg = ::vt::makeMessage< detail::ghost_request_msg >();
-      msg->idx = idx;
-      msg->proxy = _narrow->getCollectionProxy();
-      // msg->ordering = 0;
-      msg->dest_node = rank;
       auto this_idx = collision_object_impl::vt_index{ static_cast< std::size_t >( idx[0] ) };
-      logger.trace( "<send={}> obj={} requesting primary patch {} from object {}", this_idx, this_obj->id(), this_idx.x(),
-                    this_obj->id() );
-      this_obj->get_impl()
-        .narrowphase_patch_collection_proxy[this_idx]
-        .sendMsg< detail::ghost_request_msg, &detail::request_ghost >( msg.get() );
-
-      // Send ghost request to other obj
-      auto other_msg = ::vt::makeMessage< detail::ghost_request_msg >();
-      other_msg->idx = idx;
-      other_msg->proxy = _narrow->getCollectionProxy();
-      other_msg->dest_node = rank;
-      // other_msg->ordering = 1;
       auto other_idx = collision_object_impl::vt_index{ static_cast< std::size_t >( idx[2] ) };
-      logger.trace( "<send={}> obj={} requesting secondary patch {} from object {}", other_idx, this_obj->id(), other_idx.x(),
-                    other_obj->id() );
-      other_obj->get_impl()
-        .narrowphase_patch_collection_proxy[other_idx]
-        .sendMsg< detail::ghost_request_msg, &detail::request_ghost >( other_msg.get() );
+      auto rank = ::vt::theContext()->getNode();
+
+      // Patches owned by this rank don't need a ghost, cache them straight from the local data so pairs of
+      // two local patches run right away, before any ghost request of this rank is sent
+      auto cache_if_local = [rank]( collision_object &_obj, collision_object_impl::vt_index _idx ) {
+        auto &obj_impl = _obj.get_impl();
+        const auto od_offset = static_cast< std::size_t >( rank ) * obj_impl.overdecomposition;
+        if ( _idx.x() < od_offset || _idx.x() >= od_offset + obj_impl.local_patches.size() )
+          return;
+        if ( obj_impl.cache_local_patch( _idx.x() - od_offset ) )
+          get_impl( *obj_impl.world ).narrowphase_scheduler.payload_ready( { obj_impl.collision_idx, _idx.x() } );
+      };
+      cache_if_local( *this_obj, this_idx );
+      cache_if_local( *other_obj, other_idx );
+
+      const bool this_cached = this_obj->get_impl().cached_patch( this_idx ) != nullptr;
+      // Both patches of a pair may be the same patch of a multi-body object, only request it once
+      const bool other_cached = ( self_pair && this_idx.x() == other_idx.x() ) || other_obj->get_impl().cached_patch( other_idx ) != nullptr;
+
+      // Register the pair before requesting anything so a payload can't arrive before its task
+      std::array< collision_world_impl::narrowphase_scheduler::payload_key, 2 > missing;
+      std::size_t nmissing = 0;
+      if ( !this_cached )
+        missing[nmissing++] = { this_obj->id(), this_idx.x() };
+      if ( !other_cached )
+        missing[nmissing++] = { other_obj->id(), other_idx.x() };
+
+      auto &scheduler = get_impl( *this_obj->get_impl().world ).narrowphase_scheduler;
+      if ( nmissing == 0 )
+      {
+        scheduler.add_task( {}, [this_obj, other_obj, idx]() { run_narrowphase( *this_obj, *other_obj, idx ); } );
+      } else {
+        // The task may be completed by a ghost sent in another epoch, keep ours open until it has run
+        // and send its results in it
+        auto epoch = ::vt::theMsg()->getEpoch();
+        ::vt::theTerm()->produce( epoch );
+        scheduler.add_task( span< const collision_world_impl::narrowphase_scheduler::payload_key >( missing.data(), nmissing ),
+                            [this_obj, other_obj, idx, epoch]() {
+                              ::vt::theMsg()->pushEpoch( epoch );
+                              run_narrowphase( *this_obj, *other_obj, idx );
+                              ::vt::theMsg()->popEpoch( epoch );
+                              ::vt::theTerm()->consume( epoch );
+                            } );
+      }
+
+      if ( this_cached )
+      {
+        SPDLOG_LOGGER_TRACE( &logger, "obj={} primary patch {} already cached", this_obj->id(), this_idx.x() );
+      } else {
+        // Send ghost request to this obj
+        auto msg = ::vt::makeMessage< detail::ghost_request_msg >();
+        msg->idx = idx;
+        msg->proxy = _narrow->getCollectionProxy();
+        // msg->ordering = 0;
+        msg->dest_node = rank;
+        SPDLOG_LOGGER_TRACE( &logger, "<send={}> obj={} requesting primary patch {} from object {}", this_idx, this_obj->id(), this_idx.x(),
+                                      this_obj->id() );
+        this_obj->get_impl()
+          .narrowphase_patch_collection_proxy[this_idx]
+          .sendMsg< detail::ghost_request_msg, &detail::request_ghost >( msg.get() );
+      }
+
+      if ( other_cached )
+      {
+        SPDLOG_LOGGER_TRACE( &logger, "obj={} secondary patch {} already cached", other_obj->id(), other_idx.x() );
+      } else {
+        // Send ghost request to other obj
+        auto other_msg = ::vt::makeMessage< detail::ghost_request_msg >();
+        other_msg->idx = idx;
+        other_msg->proxy = _narrow->getCollectionProxy();
+        other_msg->dest_node = rank;
+        // other_msg->ordering = 1;
+        SPDLOG_LOGGER_TRACE( &logger, "<send={}> obj={} requesting secondary patch {} from object {}", other_idx, this_obj->id(), other_idx.x(),
+                                      other_obj->id() );
+        other_obj->get_impl()
+          .narrowphase_patch_collection_proxy[other_idx]
+          .sendMsg< detail::ghost_request_msg, &detail::request_ghost >( other_msg.get() );
+      }
     }
 
-    void start_narrowphase( narrowphase_collection_type *_narrow, start_narrowphase_msg * )
+    void run_narrowphase( collision_object &_this_obj, collision_object &_other_obj, narrowphase_index _idx )
     {
-      auto idx = _narrow->getIndex();
+      auto &this_impl = _this_obj.get_impl();
+      auto &other_impl = _other_obj.get_impl();
 
-      auto &this_obj = *_narrow->this_proxy.get()->self;
-      auto &other_obj = *_narrow->other_proxy.get()->self;
-      auto &this_impl = this_obj.get_impl();
-      auto &other_impl = other_obj.get_impl();
-
-      auto &logger = this_obj.narrowphase_logger();
-      logger.debug( "executing narrowphase <{}, {}, {}, {}> in epoch={}", this_obj.id(), idx[0], idx[1],
-                    idx[2], ::vt::theMsg()->getEpoch() );
+      auto &logger = _this_obj.narrowphase_logger();
+      SPDLOG_LOGGER_DEBUG( &logger, "executing narrowphase <{}, {}, {}, {}> in epoch={}", _this_obj.id(), _idx[0], _idx[1],
+                                    _idx[2], ::vt::theMsg()->getEpoch() );
 
       // Run actual narrowphase functor
-      auto &world = *this_obj.get_impl().world;
+      auto &world = *_this_obj.get_impl().world;
       auto &world_impl = get_impl( world );
 
-      auto this_index = vt_index{ static_cast< std::size_t >( idx[0] ) };
-      auto other_index = vt_index{ static_cast< std::size_t >( idx[2] ) };
+      auto this_index = vt_index{ static_cast< std::size_t >( _idx[0] ) };
+      auto other_index = vt_index{ static_cast< std::size_t >( _idx[2] ) };
 
       // Only run if we are looking at the right "other obj"
-      if ( other_obj.get_impl().collision_idx != static_cast< std::size_t >( idx.y() ) )
+      if ( _other_obj.get_impl().collision_idx != static_cast< std::size_t >( _idx.y() ) )
       {
-        logger.trace( "skipping <{}, {}, {}, {}> -- mismatched index",
-                      this_obj.id(), idx[0], idx[1], idx[2] );
+        SPDLOG_LOGGER_TRACE( &logger, "skipping <{}, {}, {}, {}> -- mismatched index",
+                                      _this_obj.id(), _idx[0], _idx[1], _idx[2] );
         return;
       }
 
-      // Ignore self collisions (this will usually be caught by the above condition)
-      if ( this_obj.get_impl().collision_idx == static_cast< std::size_t >( idx.y() ) )
+      // Ignore self collisions (this will usually be caught by the above condition), unless the bodies of a
+      // multi-body object are colliding with each other
+      const bool self_pair = ( _this_obj.get_impl().collision_idx == static_cast< std::size_t >( _idx.y() ) );
+      if ( self_pair && !this_impl.multi_body )
       {
-        logger.trace( "skipping <{}, {}, {}, {}> -- self collision",
-                      this_obj.id(), idx[0], idx[1], idx[2] );
+        SPDLOG_LOGGER_TRACE( &logger, "skipping <{}, {}, {}, {}> -- self collision",
+                                      _this_obj.id(), _idx[0], _idx[1], _idx[2] );
         return;
       }
 
-      BVH_ASSERT_ALWAYS( this_impl.narrowphase_patch_cache.find( this_index ) != this_impl.narrowphase_patch_cache.end(),
+      const auto *this_cached = this_impl.cached_patch( this_index );
+      BVH_ASSERT_ALWAYS( this_cached != nullptr,
                          logger,
                          "this_index={} - not present in `narrowphase_patch_cache`",
                          this_index );
-      const auto &this_cache = this_impl.narrowphase_patch_cache.at( this_index );
+      const auto &this_cache = *this_cached;
 
-      BVH_ASSERT_ALWAYS( other_impl.narrowphase_patch_cache.find( other_index ) != other_impl.narrowphase_patch_cache.end(),
+      const auto *other_cached = other_impl.cached_patch( other_index );
+      BVH_ASSERT_ALWAYS( other_cached != nullptr,
                          logger,
                          "other_index={} - not present in `narrowphase_patch_cache`",
                          other_index );
-      const auto &other_cache = other_impl.narrowphase_patch_cache.at( other_index );
+      const auto &other_cache = *other_cached;
 
       ::vt::NodeType left_node = this_cache.origin_node;
       ::vt::NodeType right_node = other_cache.origin_node;
 
+      phase_timer timer( this_impl.adaptive_overdecomposition(), this_impl.local_phase_times.narrowphase );
+
+      // Cull the elements tree-vs-tree if both patches came with an element tree
+      std::vector< std::pair< std::size_t, std::size_t > > candidates;
+      if ( this_cache.element_tree && other_cache.element_tree )
+      {
+        if ( self_pair )
+        {
+          // The leafs carry the body ids. Skip the elements of the same body, and when both patches are the
+          // same only keep one ordering of each pair
+          const bool same_patch = ( this_index.x() == other_index.x() );
+          overlapping_local_indices( *this_cache.element_tree, *other_cache.element_tree, candidates,
+                                     [same_patch]( const auto &_a, const auto &_b ) {
+                                       return _a.global_id() != _b.global_id()
+                                              && ( !same_patch || _a.local_index() < _b.local_index() );
+                                     } );
+        } else {
+          overlapping_local_indices( *this_cache.element_tree, *other_cache.element_tree, candidates );
+        }
+        if ( candidates.empty() )
+        {
+          SPDLOG_LOGGER_TRACE( &logger, "skipping <{}, {}, {}, {}> -- no overlapping elements",
+                                        _this_obj.id(), _idx[0], _idx[1], _idx[2] );
+          return;
+        }
+      }
+
+      if ( world_impl.batch_functor )
+      {
+        SPDLOG_LOGGER_TRACE( &logger, "batching <{}, {}, {}, {}>", _this_obj.id(), _idx[0], _idx[1], _idx[2] );
+        this_impl.narrowphase_batches[{ other_impl.collision_idx, this_index.x() }].push_back(
+          { other_index, std::move( candidates ) } );
+        return;
+      }
+
+      if ( world_impl.parallel_narrowphase )
+      {
+        SPDLOG_LOGGER_TRACE( &logger, "queueing <{}, {}, {}, {}>", _this_obj.id(), _idx[0], _idx[1], _idx[2] );
+        this_impl.narrowphase_queue[other_impl.collision_idx].push_back( { this_index, other_index, std::move( candidates ) } );
+        return;
+      }
+
       if ( world_impl.functor )
       {
         ::vt::trace::TraceScopedEvent scope( world_impl.bvh_impl_functor_ );
-        auto r = world_impl.functor( this_obj, this_cache.meta, static_cast< std::size_t >( idx[0] ),
-                                     this_cache.patch_data.data(), this_cache.patch_data.size(), other_obj,
-                                     other_cache.meta, static_cast< std::size_t >( idx[2] ),
-                                     other_cache.patch_data.data(), other_cache.patch_data.size() );
+        auto r = world_impl.functor( _this_obj, this_cache.meta, static_cast< std::size_t >( _idx[0] ),
+                                     this_cache.patch_data.data(), this_cache.patch_data.size(), _other_obj,
+                                     other_cache.meta, static_cast< std::size_t >( _idx[2] ),
+                                     other_cache.patch_data.data(), other_cache.patch_data.size(),
+                                     span< const std::pair< std::size_t, std::size_t > >( candidates.data(), candidates.size() ) );
 
         if ( r.a.size() > 0 )
         {
-          auto lmsg = ::vt::makeMessage< result_msg >();
-          lmsg->result = std::move( r.a );
-          logger.trace( "<send={}> result from <{}, {}, {}, {}>",
-                        left_node, this_obj.id(), idx[0], idx[1], idx[2] );
-          this_obj.get_impl()
-            .objgroup[left_node]
-            .sendMsg< result_msg, &collision_object_impl::collision_object_holder::set_result >( lmsg );
+          SPDLOG_LOGGER_TRACE( &logger, "<send={}> result from <{}, {}, {}, {}>",
+                                        left_node, _this_obj.id(), _idx[0], _idx[1], _idx[2] );
+          send_result( _this_obj, left_node, std::move( r.a ) );
         }
 
         if ( r.b.size() > 0 )
         {
-          auto rmsg = ::vt::makeMessage< result_msg >();
-          rmsg->result = std::move( r.b );
-          logger.trace( "<send={}> result from <{}, {}, {}, {}>",
-                        right_node, this_obj.id(), idx[0], idx[1], idx[2] );
-          this_obj.get_impl()
-            .objgroup[right_node]
-            .sendMsg< result_msg, &collision_object_impl::collision_object_holder::set_result >( rmsg );
+          SPDLOG_LOGGER_TRACE( &logger, "<send={}> result from <{}, {}, {}, {}>",
+                                        right_node, _this_obj.id(), _idx[0], _idx[1], _idx[2] );
+          send_result( _this_obj, right_node, std::move( r.b ) );
         }
       }
     }
@@ -354,8 +660,8 @@ namespace bvh
       auto &this_obj = *_narrow->this_proxy.get()->self;
       auto &logger = this_obj.narrowphase_logger();
       const auto idx = _narrow->getIndex();
-      logger.trace( "clearing narrowphase index <{}, {}, {}, {}>",
-                    this_obj.id(), idx[0], idx[1], idx[2] );
+      SPDLOG_LOGGER_TRACE( &logger, "clearing narrowphase index <{}, {}, {}, {}>",
+                                    this_obj.id(), idx[0], idx[1], idx[2] );
       _narrow->active = false;
     }
 
@@ -34,11 +34,15 @@
 #define INC_BVH_COLLISION_OBJECT_IMPL_HPP
 
 #include <vector>
+#include <map>
 #include <optional>
+#include <limits>
+#include <algorithm>
 #include "../collision_object.hpp"
 #include "types.hpp"
 #include "../collision_world/impl.hpp"
 #include "../split/element_permutations.hpp"
+#include "../split/overdecomposition.hpp"
 
 #include <vt/transport.h>
 #include <vt/messaging/collection_chain_set.h>
@@ -54,11 +58,12 @@ namespace bvh
       const auto &obj = *_patch->collision_object.get()->self;
       auto &logger = obj.narrowphase_logger();
       auto idx = _patch->getIndex();
-      logger.debug( "late initializing narrowphase patch {} with {} bytes", idx.x(), _msg->data_size );
-      _patch->ghost_destinations.clear();
+      SPDLOG_LOGGER_DEBUG( &logger, "late initializing narrowphase patch {} with {} bytes", idx.x(), _msg->data_size );
+      _patch->set_generation( _msg->generation );
       _patch->patch_meta = _msg->patch_meta;
       _patch->bytes.resize(_msg->data_size);
       std::memcpy( _patch->bytes.data(), _msg->user_data(), _msg->data_size );
+      _patch->tree_bytes.assign( _msg->tree_data(), _msg->tree_data() + _msg->tree_size );
       _patch->origin_node = _msg->origin_node;
     }
   }
@@ -77,8 +82,43 @@ namespace bvh
     using narrowphase_patch_collection_type = collision_object_impl::narrowphase_patch_collection_type;
 
     using narrowphase_collection_type = collision_object_impl::narrowphase_collection_type;
+    using kdop_type = collision_object_impl::kdop_type;
     using ghost_table_index = collision_object_impl::narrowphase_index;
 
+    /// \brief Number of elements in the given local patch
+    std::size_t local_patch_size( std::size_t _local_idx ) const
+    {
+      const auto sbeg = ( _local_idx == 0 ) ? 0 : splits_h( _local_idx - 1 );
+      const auto send = ( _local_idx == num_splits ) ? split_indices_h.extent( 0 ) : splits_h( _local_idx );
+      return send - sbeg;
+    }
+
+    /**
+     * @brief Copy the user data of the elements of a local patch, in patch order, to `_dest`
+     *
+     * @param _local_idx the local patch index
+     * @param _dest buffer of at least `local_patch_size( _local_idx ) * m_entity_unit_size` bytes
+     */
+    void copy_local_patch_data( std::size_t _local_idx, unsigned char *_dest ) const
+    {
+      const auto sbeg = ( _local_idx == 0 ) ? 0 : splits_h( _local_idx - 1 );
+      const auto send = ( _local_idx == num_splits ) ? split_indices_h.extent( 0 ) : splits_h( _local_idx );
+
+      if ( m_entity_gather )
+      {
+        m_entity_gather( span< const std::size_t >( split_indices_h.data() + sbeg, send - sbeg ), _dest );
+        return;
+      }
+
+      std::size_t offset = 0;
+      for ( std::size_t j = sbeg; j < send; ++j )
+      {
+        debug_assert( split_indices_h( j ) < snapshots.extent( 0 ), "user index is out of bounds" );
+        std::memcpy( _dest + offset, m_entity_ptr + ( split_indices_h( j ) * m_entity_unit_size ), m_entity_unit_size );
+        offset += m_entity_unit_size;
+      }
+    }
+
     /**
      * @brief Copy the local data pointed to by m_entity_ptr at the offset corresponding to the
      * permutation for the given local element index
@@ -95,30 +135,31 @@ namespace bvh
       using narrowphase_patch_msg = collision_object_impl::narrowphase_patch_msg;
 
       const auto idx = _local_idx;
-      const auto sbeg = ( idx == 0 ) ? 0 : splits_h( idx - 1 );
-      const auto send = ( idx == num_splits ) ? split_indices_h.extent( 0 ) : splits_h( idx );
-      const std::size_t nelements = send - sbeg;
+      const std::size_t nelements = local_patch_size( idx );
       const std::size_t chunk_data_size = nelements * m_entity_unit_size;
       const int rank = _rank;
       debug_assert( m_entity_unit_size > 0, "entity unit size must be > 0" );
 
-      auto send_msg = ::vt::makeMessageSz< narrowphase_patch_msg >( chunk_data_size );
+      // Shipped after the elements so the receiving nodes don't have to rebuild it
+      ::checkpoint::SerializedReturnType tree_buffer;
+      if ( ships_element_trees() && idx < element_trees.size() )
+        tree_buffer = ::checkpoint::serialize( element_trees[idx] );
+      const std::size_t tree_size = tree_buffer ? tree_buffer->getSize() : 0;
+
+      auto send_msg = ::vt::makeMessageSz< narrowphase_patch_msg >( chunk_data_size + tree_size );
       send_msg->data_size = chunk_data_size;
+      send_msg->tree_size = tree_size;
+      if ( tree_size > 0 )
+        std::memcpy( send_msg->tree_data(), tree_buffer->getBuffer(), tree_size );
 
-      std::size_t offset = 0;
-      logger.debug( "obj={} sending narrowphase patch {} with {} num elements",
-                    collision_idx, vt_index{ _local_idx + rank * overdecomposition }, nelements );
+      SPDLOG_LOGGER_DEBUG( &logger, "obj={} sending narrowphase patch {} with {} num elements",
+                                    collision_idx, vt_index{ _local_idx + rank * overdecomposition }, nelements );
       // Should be replaced with VT serialization
-      for (std::size_t j = sbeg; j < send; ++j)
-      {
-        debug_assert( offset < send_msg->data_size, "split index offset={} is out of bounds (local data size is {})", offset, send_msg->data_size );
-        debug_assert( split_indices_h( j ) < snapshots.extent( 0 ), "user index is out of bounds" );
-        std::memcpy( &send_msg->user_data()[offset], m_entity_ptr + (split_indices_h( j ) * m_entity_unit_size), m_entity_unit_size);
-        offset += m_entity_unit_size;
-      }
+      copy_local_patch_data( idx, send_msg->user_data() );
 
       send_msg->origin_node = rank;
       send_msg->patch_meta = local_patches[idx];
+      send_msg->generation = ghost_generation;
 
       return send_msg;
     }
@@ -135,8 +176,19 @@ namespace bvh
     std::vector< ::vt::MsgPtr< collision_object_impl::narrowphase_patch_msg > > narrowphase_patch_messages;
     std::vector< std::size_t > local_data_indices;
 
+    /// \brief Hand a narrowphase result of this rank to the result stream, or keep it for `for_each_result`
+    void store_result( narrowphase_result &&_result )
+    {
+      if ( result_stream )
+        result_stream( _result );
+      else
+        local_results.emplace_back( std::move( _result ) );
+    }
+
     // Not a collection because we want this to always live on a per-node basis
     std::vector< narrowphase_result > local_results;
+    /// Set by `stream_results`, receives results as they arrive instead of `local_results`
+    std::function< void( const narrowphase_result & ) > result_stream;
 
     ::vt::messaging::CollectionChainSet< vt_index > chainset;
     std::size_t overdecomposition = 1;
@@ -157,31 +209,146 @@ namespace bvh
 
     collision_object_impl::collision_object_proxy_type objgroup;
     tree_type tree;
+    kdop_type global_bounds; ///< Union of every patch's bounds, set alongside `tree`
+
+    bool build_element_trees = false;
+    std::vector< tree_type > element_trees; ///< Tree of the elements of each local patch, leafs are referenced by their position in the patch
+
+    bool multi_body = false;
+    std::vector< std::size_t > body_ids; ///< Body of each (original) element of a multi-body object
+
+    /// \brief Whether the local patches get an element tree, which a multi-body object needs for the body filter
+    bool ships_element_trees() const noexcept { return build_element_trees || multi_body; }
+
+    /// Set by the bounds check at the start of each `broadphase` call. When the global bounds
+    /// of the two objects are disjoint, the remaining steps of that pairwise pipeline are no-ops.
+    bool broadphase_culled = false;
 
     std::vector< collision_object_impl::narrowphase_index > active_narrowphase_indices;
-    std::unordered_set< size_t > active_narrowphase_local_index;
+    std::vector< bool > active_narrowphase_local_index; ///< Per local patch, whether it is in a narrowphase pair this step
 
     const unsigned char *m_entity_ptr;
     std::size_t m_entity_unit_size = 0;
+    entity_gather_function m_entity_gather; ///< If set, used instead of copying `m_entity_unit_size` bytes per element
     element_permutations m_latest_permutations;
 
     struct narrowphase_patch_cache_entry
     {
       patch<> meta;
       std::vector< unsigned char > patch_data;
+      std::optional< tree_type > element_tree; ///< Deserialized once per node, shared by every pair of the patch
       ::vt::NodeType origin_node;
+      std::size_t generation = std::numeric_limits< std::size_t >::max(); ///< `ghost_generation` the entry was cached in
     };
 
-    std::unordered_map< vt_index, narrowphase_patch_cache_entry > narrowphase_patch_cache;
+    /// Indexed by global patch id. Entries are only valid in the ghost generation they were cached in,
+    /// so they are reused across steps instead of being cleared
+    std::vector< narrowphase_patch_cache_entry > narrowphase_patch_cache;
+
+    /// \brief The cached payload of a patch of this object, `nullptr` if it wasn't cached this generation
+    const narrowphase_patch_cache_entry *cached_patch( vt_index _idx ) const
+    {
+      if ( _idx.x() >= narrowphase_patch_cache.size() )
+        return nullptr;
+      const auto &ent = narrowphase_patch_cache[_idx.x()];
+      return ( ent.generation == ghost_generation ) ? &ent : nullptr;
+    }
+
+    /// \brief Claim the cache entry of a patch of this object for this generation
+    ///
+    /// \return the entry and whether it wasn't cached this generation yet
+    std::pair< narrowphase_patch_cache_entry &, bool > cache_entry( vt_index _idx )
+    {
+      if ( _idx.x() >= narrowphase_patch_cache.size() )
+        narrowphase_patch_cache.resize( std::max< std::size_t >( _idx.x() + 1, overdecomposition * ::vt::theContext()->getNumNodes() ) );
+      auto &ent = narrowphase_patch_cache[_idx.x()];
+      const bool fresh = ( ent.generation != ghost_generation );
+      ent.generation = ghost_generation;
+      return { ent, fresh };
+    }
+
+    /// \brief Cache a local patch for the narrowphase, like a ghost of it would be cached
+    ///
+    /// \return whether the patch wasn't cached this generation yet
+    bool cache_local_patch( std::size_t _local_idx )
+    {
+      const auto rank = ::vt::theContext()->getNode();
+      auto [ent, inserted] = cache_entry( vt_index{ _local_idx + rank * overdecomposition } );
+      if ( !inserted )
+        return false;
+
+      ent.meta = local_patches[_local_idx];
+      ent.origin_node = rank;
+      ent.patch_data.resize( local_patch_size( _local_idx ) * m_entity_unit_size );
+      copy_local_patch_data( _local_idx, ent.patch_data.data() );
+      if ( ships_element_trees() && _local_idx < element_trees.size() )
+        ent.element_tree = element_trees[_local_idx];
+      else
+        ent.element_tree.reset();
+      return true;
+    }
+
+    struct narrowphase_batch_entry
+    {
+      vt_index other_index;
+      std::vector< std::pair< std::size_t, std::size_t > > element_candidates;
+    };
+
+    struct narrowphase_queue_entry
+    {
+      vt_index this_index;
+      vt_index other_index;
+      std::vector< std::pair< std::size_t, std::size_t > > element_candidates;
+    };
+
+    /// Pairs whose patches are cached on this rank, waiting for the parallel narrowphase. Keyed by other object id
+    std::map< std::size_t, std::vector< narrowphase_queue_entry > > narrowphase_queue;
+
+    /// Pairs whose patches are cached on this rank, waiting for the batched narrowphase functor.
+    /// Keyed by (other object id, patch id of this object). Only holds the pairs found on this rank, so
+    /// the other partners of a patch may be batched on other ranks
+    std::map< std::pair< std::size_t, std::size_t >, std::vector< narrowphase_batch_entry > > narrowphase_batches;
+
+    /// Incremented by every `init_broadphase`. Ghosts of the same generation are cached on the
+    /// receiving nodes, so they only need to be sent once no matter how many pairs use them
+    std::size_t ghost_generation = 0;
+    /// The generation each local patch was last copied to the narrowphase patch collection in
+    std::vector< std::size_t > sent_patch_generation;
 
     // Split and clustering views
     view< bvh::entity_snapshot * > snapshots;
+    bool compact_split = false;
+    view< bvh::compact_entity_snapshot * > compact_snapshots; ///< Unpermuted, only used for splitting, see `set_compact_split`
     view< std::size_t * > split_indices;  ///< Mapping from original element indices to the reordered indices
     view< std::size_t * > splits; ///< bounds of each split
     host_view< std::size_t * > split_indices_h;
     host_view< std::size_t * > splits_h;
     std::size_t num_splits = 0; ///< The number of actual splits -- may be les than splits.extent( 0 )
 
+    // Hot patch rebalancing
+    double patch_rebalance_threshold = 0.0; ///< Max/mean patch load that triggers a re-split, 0 disables
+    std::vector< std::size_t > patch_pair_counts; ///< Narrowphase pairs found per local patch this step
+    std::vector< std::size_t > last_element_patch; ///< Local patch of each (original) element last step
+
+    double patch_hysteresis_growth = 0.0; ///< Bounds growth that triggers a re-split, 0 disables hysteresis
+    double patch_hysteresis_imbalance = 0.0; ///< Max/mean patch load that triggers a re-split, 0 ignores the load
+    bool patch_assignment_kept = false;
+    std::vector< kdop_type > reference_patch_bounds; ///< Bounds of each local patch when its elements were assigned
+    std::vector< patch_membership_change > patch_membership_changes;
+    bool restored_state = false; ///< Set by `load_state`, the next `set_entity_data` keeps the restored assignment
+
+    // Adaptive overdecomposition, see `set_adaptive_overdecomposition`
+    std::size_t adaptive_od_min = 1;
+    std::size_t adaptive_od_max = 0; ///< 0 disables the adaptive overdecomposition
+    std::size_t adaptive_od_sample_steps = 0;
+    double adaptive_od_min_gain = 0.0;
+    std::size_t adaptive_od_steps = 0; ///< Steps timed in the current sampling window
+    phase_times local_phase_times; ///< Times of this rank in the current sampling window
+    phase_costs reduced_phase_costs; ///< Set by the collective `reduce_phase_times`
+
+    /// \brief Whether the phases are timed for the adaptive overdecomposition
+    bool adaptive_overdecomposition() const noexcept { return adaptive_od_max > 0; }
+
     // Loggers
     std::shared_ptr< spdlog::logger > logger;
     std::shared_ptr< spdlog::logger > broadphase_logger;
@@ -192,7 +359,14 @@ namespace bvh
   {
     void activate_narrowphase( collision_object_impl::narrowphase_collection_type *_narrow, activate_narrowphase_msg *_msg );
     void start_ghosting( collision_object_impl::narrowphase_collection_type *_narrow, start_ghosting_msg *_msg );
-    void start_narrowphase( collision_object_impl::narrowphase_collection_type *_narrow, start_narrowphase_msg *_msg );
+    /// \brief Run the narrowphase functor on a pair whose patches are both cached on this rank and send the results
+    /// to the ranks that own the patches
+    void run_narrowphase( collision_object &_this_obj, collision_object &_other_obj, narrowphase_index _idx );
+    /// \brief Run the batched narrowphase functor on every pair of `_this_obj` and `_other_obj` collected on this rank
+    void run_narrowphase_batches( collision_object &_this_obj, collision_object &_other_obj );
+    /// \brief Run the narrowphase functor on every queued pair of `_this_obj` and `_other_obj` in a Kokkos
+    /// `parallel_for` on the host, see `world_config::parallel_narrowphase`
+    void run_queued_narrowphase( collision_object &_this_obj, collision_object &_other_obj );
     void clear_narrowphase( collision_object_impl::narrowphase_collection_type *_narrow, clear_narrowphase_msg *_msg );
   } // namespace collision_object_impl
 
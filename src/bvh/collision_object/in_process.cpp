@@ -0,0 +1,132 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "in_process.hpp"
+#include "broadphase.hpp"
+#include "impl.hpp"
+#include "../collision_query.hpp"
+#include "../tree_build.hpp"
+#include "../vt/print.hpp"
+
+namespace bvh
+{
+  namespace collision_object_impl
+  {
+    void build_local_tree( collision_object::impl &_impl )
+    {
+
+      std::vector< entity_snapshot > snapshots;
+      snapshots.reserve( _impl.local_patches.size() );
+      kdop_type bounds;
+      for ( std::size_t i = 0; i < _impl.local_patches.size(); ++i )
+      {
+        const auto &patch = _impl.local_patches[i];
+        // Don't build a snapshot of an empty patch
+        if ( patch.empty() )
+          continue;
+        snapshots.push_back( make_snapshot( patch, i ) );
+        bounds.union_with( snapshots.back().kdop() );
+      }
+
+      SPDLOG_LOGGER_DEBUG( _impl.logger, "obj={} building tree of {} local patches", _impl.collision_idx, snapshots.size() );
+      _impl.tree = build_tree_top_down< tree_type >( snapshots );
+      _impl.global_bounds = bounds;
+    }
+
+    void local_broadphase( collision_object &_this_obj, collision_object &_other_obj,
+                           broadphase_orientation _orientation )
+    {
+      auto &this_impl = _this_obj.get_impl();
+      auto &other_impl = _other_obj.get_impl();
+      auto &logger = _this_obj.broadphase_logger();
+
+      this_impl.broadphase_culled = this_impl.build_trees && other_impl.build_trees
+                                    && !overlap( this_impl.global_bounds, other_impl.global_bounds );
+      if ( this_impl.broadphase_culled )
+      {
+        SPDLOG_LOGGER_DEBUG( &logger, "obj={} target_obj={} global bounds {} and {} are disjoint, culling pair", _this_obj.id(),
+                                      _other_obj.id(), this_impl.global_bounds, other_impl.global_bounds );
+        return;
+      }
+
+      const bool swapped = query_other_patches( this_impl, other_impl, _orientation );
+      auto &patch_obj = swapped ? _other_obj : _this_obj;
+      auto &tree_obj = swapped ? _this_obj : _other_obj;
+      auto &patch_impl = patch_obj.get_impl();
+      auto &tree_impl = tree_obj.get_impl();
+
+      logger.info( "starting in-process broadphase between body {} and {}", _this_obj.id(), _other_obj.id() );
+
+      // Patch ids are local ids, this rank owns every patch
+      const bool self_pair = ( &patch_obj == &tree_obj );
+      std::vector< narrowphase_index > pairs;
+      {
+        phase_timer timer( patch_impl.adaptive_overdecomposition(), patch_impl.local_phase_times.broadphase );
+
+        // There is no scheduler to spread the patches over, so always use the threads of the rank
+        auto hits = query_local_patches( patch_impl, tree_impl.tree, self_pair );
+
+        for ( auto &&patch_hits : hits )
+        {
+          for ( auto &&[p, q] : patch_hits )
+          {
+            // As in the distributed broadphase, the index is ordered as seen from `_this_obj`
+            narrowphase_index idx( static_cast< int >( swapped ? q : p ), static_cast< int >( other_impl.collision_idx ),
+                                   static_cast< int >( swapped ? p : q ) );
+            SPDLOG_LOGGER_TRACE( &logger, "found broadphase contact <{}, {}, {}, {}>", patch_obj.id(), p, tree_obj.id(), q );
+            pairs.push_back( idx );
+            this_impl.active_narrowphase_indices.emplace_back( idx );
+
+            patch_impl.active_narrowphase_local_index[p] = true;
+            ++patch_impl.patch_pair_counts[p];
+            tree_impl.active_narrowphase_local_index[q] = true;
+            if ( !self_pair || p != q )
+              ++tree_impl.patch_pair_counts[q];
+
+            patch_impl.cache_local_patch( p );
+            tree_impl.cache_local_patch( q );
+          }
+        }
+      }
+
+      SPDLOG_LOGGER_DEBUG( &logger, "obj={} target_obj={} running narrowphase of {} pairs in-process", _this_obj.id(), _other_obj.id(),
+                                    pairs.size() );
+      for ( auto &&idx : pairs )
+        run_narrowphase( _this_obj, _other_obj, idx );
+
+      if ( get_impl( *this_impl.world ).batch_functor )
+        run_narrowphase_batches( _this_obj, _other_obj );
+      else if ( get_impl( *this_impl.world ).parallel_narrowphase )
+        run_queued_narrowphase( _this_obj, _other_obj );
+    }
+  }
+}
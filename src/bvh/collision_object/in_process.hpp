@@ -0,0 +1,58 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef INC_BVH_COLLISION_OBJECT_IN_PROCESS_HPP
+#define INC_BVH_COLLISION_OBJECT_IN_PROCESS_HPP
+
+#include "types.hpp"
+#include "../collision_object.hpp"
+
+namespace bvh
+{
+  namespace collision_object_impl
+  {
+    /// \brief Build the broadphase tree and global bounds of an object from its local patches
+    ///
+    /// Equivalent to the tree build reduction when this rank owns every patch.
+    void build_local_tree( collision_object::impl &_impl );
+
+    /// \brief Run the broadphase and narrowphase of two objects whose patches are all on this rank
+    ///
+    /// Pairs are found, counted and recorded for `_this_obj` like the distributed pipeline does, but the patches
+    /// are queried in parallel on the host threads, passed to the narrowphase functor directly and the results
+    /// are stored without any messages.
+    void local_broadphase( collision_object &_this_obj, collision_object &_other_obj,
+                           broadphase_orientation _orientation );
+  }
+}
+
+#endif  // INC_BVH_COLLISION_OBJECT_IN_PROCESS_HPP
@@ -53,22 +53,17 @@ namespace bvh
       return _this_obj[::vt::theContext()->getNode()].sendMsg< clear_narrowphase_msg, &collision_object_impl::collision_object_holder::clear_narrowphase >( msg );
     }
 
-    pending_send narrowphase( [[maybe_unused]] vt_index _local_idx, collision_object_proxy_type _this_obj )
-    {
-      auto msg = ::vt::makeMessage< start_narrowphase_msg >();
-      return _this_obj[::vt::theContext()->getNode()].sendMsg< start_narrowphase_msg, &collision_object_impl::collision_object_holder::start_narrowphase >( msg );
-    }
-
     namespace details
     {
       void
       copy_narrowphase_patch( collision_object_impl::narrowphase_patch_collection_type *_patch,
                               narrowphase_patch_msg *_msg )
       {
-        _patch->ghost_destinations.clear();
+        _patch->set_generation( _msg->generation );
         _patch->patch_meta = _msg->patch_meta;
         _patch->bytes.resize(_msg->data_size);
         std::memcpy( _patch->bytes.data(), _msg->user_data(), _msg->data_size );
+        _patch->tree_bytes.assign( _msg->tree_data(), _msg->tree_data() + _msg->tree_size );
         _patch->origin_node = _msg->origin_node;
       }
     } // namespace details
@@ -96,45 +91,24 @@ namespace bvh
       auto msg = ::vt::makeMessage< start_ghosting_msg >();
       msg->this_obj = this_obj->get_impl().objgroup;
       msg->other_obj = other_obj->get_impl().objgroup;
-      logger.debug( "<send=local> requesting ghosts for objects {} and {} in potential collision", this_obj->id(), other_obj->id() );
+      SPDLOG_LOGGER_DEBUG( &logger, "<send=local> requesting ghosts for objects {} and {} in potential collision", this_obj->id(), other_obj->id() );
       return _this_obj[::vt::theContext()->getNode()].sendMsg< start_ghosting_msg, &collision_object_impl::collision_object_holder::request_ghosts >( msg );
     }
 
-    namespace detail
+    pending_send run_narrowphase_batches( [[maybe_unused]] vt_index _local_idx, collision_object_proxy_type _this_obj,
+                                          collision_object_proxy_type _other_obj )
     {
-      struct send_ghost_msg : ::vt::CollectionMessage< collision_object_impl::narrowphase_patch_collection_type >
-      {
-        collision_object_proxy_type obj;
-      };
-
-      void
-      send_ghost( collision_object_impl::narrowphase_patch_collection_type *_patch, send_ghost_msg *_msg )
-      {
-        const auto &obj = *_patch->collision_object.get()->self;
-        auto &logger = obj.narrowphase_logger();
-        logger.debug( "obj={} index {} has {} destinations", obj.id(), _patch->getIndex(), _patch->ghost_destinations.size() );
-        for ( auto &&d : _patch->ghost_destinations )
-        {
-          logger.debug( "<send={}> obj={} sending ghost for idx {}", d, obj.id(), _patch->getIndex() );
-          auto msg = ::vt::makeMessage< ghost_msg >();
-          msg->meta = _patch->patch_meta;
-          msg->patch_data = _patch->bytes;
-          msg->origin_node = _patch->origin_node;
-          msg->idx = _patch->getIndex();
-
-          _msg->obj[d].sendMsg< ghost_msg, &collision_object_impl::collision_object_holder::cache_patch >( msg );
-        }
-      }
-    } // namespace detail
+      auto msg = ::vt::makeMessage< narrowphase_batches_msg >();
+      msg->other_obj = _other_obj;
+      return _this_obj[::vt::theContext()->getNode()].sendMsg< narrowphase_batches_msg, &collision_object_impl::collision_object_holder::run_narrowphase_batches >( msg );
+    }
 
-    pending_send ghost( vt_index _global_idx,
-                        collision_object_proxy_type _obj,
-                        narrowphase_patch_collection_type::CollectionProxyType _patches )
+    pending_send run_queued_narrowphase( [[maybe_unused]] vt_index _local_idx, collision_object_proxy_type _this_obj,
+                                         collision_object_proxy_type _other_obj )
     {
-      auto msg = ::vt::makeMessage< detail::send_ghost_msg >();
-      msg->obj = _obj;
-      return _patches[_global_idx].sendMsg< detail::send_ghost_msg, &detail::send_ghost >( msg );
+      auto msg = ::vt::makeMessage< narrowphase_queue_msg >();
+      msg->other_obj = _other_obj;
+      return _this_obj[::vt::theContext()->getNode()].sendMsg< narrowphase_queue_msg, &collision_object_impl::collision_object_holder::run_queued_narrowphase >( msg );
     }
-
   }
 }
@@ -41,7 +41,6 @@ namespace bvh
   {
     pending_send activate_narrowphase( vt_index _local_idx, collision_object_proxy_type _this_obj );
     pending_send clear_narrowphase( vt_index _local_idx, collision_object_proxy_type _this_obj );
-    pending_send narrowphase( vt_index _local_idx, collision_object_proxy_type _this_obj );
     pending_send check_active_narrowphase_arrays( vt_index _global_idx, vt_index _local_idx,
                         int _rank,
                         collision_object_proxy_type _obj,
@@ -53,10 +52,12 @@ namespace bvh
     pending_send request_ghosts( vt_index _local_idx,
                               collision_object_proxy_type _this_obj,
                               collision_object_proxy_type _other_obj );
-
-    pending_send ghost( vt_index _global_idx,
-                        collision_object_proxy_type _obj,
-                        narrowphase_patch_collection_type::CollectionProxyType _patches );
+    pending_send run_narrowphase_batches( vt_index _local_idx,
+                                          collision_object_proxy_type _this_obj,
+                                          collision_object_proxy_type _other_obj );
+    pending_send run_queued_narrowphase( vt_index _local_idx,
+                                         collision_object_proxy_type _this_obj,
+                                         collision_object_proxy_type _other_obj );
   }
 }
 
@@ -0,0 +1,130 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "overdecomposition.hpp"
+#include "impl.hpp"
+#include "types.hpp"
+
+#include <vt/collective/reduce/operators/functors/plus_op.h>
+
+namespace bvh
+{
+  namespace collision_object_impl
+  {
+    namespace
+    {
+      struct phase_costs_msg : ::vt::Message
+      {
+        using MessageParentType = ::vt::Message;
+        vt_msg_serialize_required();
+
+        phase_costs costs;
+
+        template< typename Serializer >
+        void serialize( Serializer &_s )
+        {
+          MessageParentType::serialize( _s );
+          _s | costs;
+        }
+      };
+
+      class phase_times_reduction
+      {
+      public:
+
+        phase_times_reduction() = default;
+
+        phase_times_reduction( collision_object_proxy_type _collision_object, const phase_times &_times )
+          : m_collision_object_proxy( _collision_object )
+        {
+          m_costs.total = _times;
+          m_costs.max = _times;
+          m_costs.num_ranks = 1;
+        }
+
+        phase_times_reduction &operator+=( const phase_times_reduction &_other )
+        {
+          debug_assert( m_collision_object_proxy.getProxy() == _other.m_collision_object_proxy.getProxy(), "collision objects must match" );
+          m_costs.total += _other.m_costs.total;
+          m_costs.max.broadphase = std::max( m_costs.max.broadphase, _other.m_costs.max.broadphase );
+          m_costs.max.ghosting = std::max( m_costs.max.ghosting, _other.m_costs.max.ghosting );
+          m_costs.max.narrowphase = std::max( m_costs.max.narrowphase, _other.m_costs.max.narrowphase );
+          m_costs.num_ranks += _other.m_costs.num_ranks;
+          return *this;
+        }
+
+        friend phase_times_reduction operator+( phase_times_reduction _lhs, const phase_times_reduction &_rhs )
+        {
+          return _lhs += _rhs;
+        }
+
+        collision_object_proxy_type collision_object_proxy() const noexcept { return m_collision_object_proxy; }
+
+        const phase_costs &costs() const noexcept { return m_costs; }
+
+        template< typename Serializer >
+        void serialize( Serializer &_s )
+        {
+          _s | m_collision_object_proxy | m_costs;
+        }
+
+      private:
+
+        collision_object_proxy_type m_collision_object_proxy;
+        phase_costs m_costs;
+      };
+
+      void set_phase_costs( collision_object *_coll_obj, phase_costs_msg *_msg )
+      {
+        _coll_obj->get_impl().reduced_phase_costs = _msg->costs;
+      }
+
+      void phase_times_reduce( const phase_times_reduction &_reduc )
+      {
+        auto msg = ::vt::makeMessage< phase_costs_msg >();
+        msg->costs = _reduc.costs();
+
+        _reduc.collision_object_proxy().broadcastMsg< phase_costs_msg, &collision_object_holder::delegate< phase_costs_msg, &set_phase_costs > >( msg );
+      }
+    }
+
+    phase_costs reduce_phase_times( collision_object_proxy_type _col_obj, const phase_times &_local_times )
+    {
+      ::vt::runInEpochCollective( "collision_object.phase_times", [&]() {
+        auto r = ::vt::theCollective()->global();
+        r->reduce< phase_times_reduce, ::vt::collective::PlusOp >( ::vt::Node{ 0 }, phase_times_reduction{ _col_obj, _local_times } );
+      } );
+
+      return _col_obj.get()->self->get_impl().reduced_phase_costs;
+    }
+  }
+}
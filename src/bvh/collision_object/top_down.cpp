@@ -57,12 +57,14 @@ namespace bvh
 
         tree_reduction( collision_object_proxy_type _collision_object )
           : m_collision_object_proxy( _collision_object ),
-            m_snapshots{}
+            m_snapshots{},
+            m_bounds{}
         {}
 
         tree_reduction( entity_snapshot _initial, collision_object_proxy_type _collision_object )
           : m_collision_object_proxy( _collision_object ),
-            m_snapshots{ _initial }
+            m_snapshots{ _initial },
+            m_bounds{ _initial.kdop() }
         {}
 
         tree_reduction &operator+=( const tree_reduction &_other )
@@ -70,6 +72,7 @@ namespace bvh
           // The collision object proxies should be the same so no need to reduce those
           debug_assert( m_collision_object_proxy.getProxy() == _other.m_collision_object_proxy.getProxy(), "collision objects must match" );
           m_snapshots += _other.m_snapshots;
+          m_bounds.union_with( _other.m_bounds );
           return *this;
         }
 
@@ -82,29 +85,41 @@ namespace bvh
 
         collision_object_proxy_type collision_object_proxy() const noexcept { return m_collision_object_proxy; }
 
+        /// \brief The union of the bounds of every patch in the reduction
+        const kdop_type &bounds() const noexcept { return m_bounds; }
+
         template< typename Serializer >
         void serialize( Serializer &_s )
         {
-          _s | m_collision_object_proxy | m_snapshots;
+          _s | m_collision_object_proxy | m_snapshots | m_bounds;
         }
 
       private:
 
         collision_object_proxy_type m_collision_object_proxy;
         reduce_vec m_snapshots;
+        kdop_type m_bounds;
       };
 
 
       BVH_HOST_DEVICE void set_broadphase_trees( collision_object *_coll_obj, broadphase_tree_msg *_msg )
       {
-        _coll_obj->get_impl().tree = _msg->tree;
+        _coll_obj->get_impl().tree = _msg->compact ? _msg->compact_tree.decode() : _msg->tree;
+        _coll_obj->get_impl().global_bounds = _msg->bounds;
       }
 
       void tree_build_reduce( const tree_reduction &_reduc )
       {
         // Build the tree
         auto msg = ::vt::makeMessage< broadphase_tree_msg >();
-        msg->tree = build_tree_top_down< tree_type >( _reduc.snapshots() );
+        auto tree = build_tree_top_down< tree_type >( _reduc.snapshots() );
+        auto &obj_impl = _reduc.collision_object_proxy().get()->self->get_impl();
+        msg->compact = get_impl( *obj_impl.world ).compact_tree_messages;
+        if ( msg->compact )
+          msg->compact_tree = compact_snapshot_tree( tree );
+        else
+          msg->tree = std::move( tree );
+        msg->bounds = _reduc.bounds();
 
         // Broadcast to every element of the collision object objgroup
         _reduc.collision_object_proxy().broadcastMsg< broadphase_tree_msg, &collision_object_holder::delegate< broadphase_tree_msg, &set_broadphase_trees > >( msg );
@@ -35,11 +35,14 @@
 
 #include "../tree.hpp"
 #include "../serialization/bvh_serialize.hpp"
+#include "../serialization/compact_tree.hpp"
 #include "../patch.hpp"
+#include "../debug/assert.hpp"
 #include <vt/configs/types/types_type.h>
 #include <vt/transport.h>
 #include <array>
-#include <unordered_set>
+#include <algorithm>
+#include <vector>
 #include "../collision_world.hpp"
 
 namespace bvh
@@ -97,12 +100,19 @@ namespace bvh
       vt_msg_serialize_required();
 
       tree_type tree;
+      compact_snapshot_tree compact_tree;  ///< Sent instead of `tree` if `compact`, see `world_config::compact_tree_messages`
+      bool compact = false;
+      kdop_type bounds;  ///< Global bounds of the object, reduced alongside the tree snapshots
 
       template< typename Serializer >
       void serialize( Serializer &_s )
       {
         MessageParentType::serialize( _s );
-        _s | tree;
+        _s | compact | bounds;
+        if ( compact )
+          _s | compact_tree;
+        else
+          _s | tree;
       }
     };
 
@@ -140,7 +150,6 @@ namespace bvh
     struct start_activate_narrowphase_msg;
     struct setup_narrowphase_msg;
     struct start_ghosting_msg;
-    struct start_narrowphase_msg;
     struct clear_narrowphase_msg;
 
     namespace messages
@@ -150,6 +159,10 @@ namespace bvh
 
     struct active_narrowphase_local_index_msg;
     struct ghost_msg;
+    struct check_bounds_msg;
+    struct broadphase_msg;
+    struct narrowphase_batches_msg;
+    struct narrowphase_queue_msg;
 
     struct collision_object_holder
     {
@@ -164,10 +177,20 @@ namespace bvh
         ( *Fun )( self, _msg );
       }
 
+      /// Where the result of a collective reduction in flight goes on this rank, set only while the reduction runs
+      void *reduce_result = nullptr;
+
+      /// \brief Move the reduced `_msg->value` to `reduce_result`, which must point to a `decltype( _msg->value )`
+      template< typename Message >
+      void receive_reduce_result( Message *_msg )
+      {
+        debug_assert( reduce_result != nullptr, "no collective reduction in flight" );
+        *static_cast< decltype( _msg->value ) * >( reduce_result ) = std::move( _msg->value );
+      }
+
       void activate_narrowphase( start_activate_narrowphase_msg *_msg );
       void setup_narrowphase( setup_narrowphase_msg *_msg );
       void request_ghosts( start_ghosting_msg *_msg );
-      void start_narrowphase( start_narrowphase_msg *_msg );
       void clear_narrowphase( clear_narrowphase_msg *_msg );
 
       void insert_active_narrow_local_index( active_narrowphase_local_index_msg *_msg );
@@ -178,6 +201,12 @@ namespace bvh
 
       void begin_narrowphase_modification( messages::modify_msg * );
       void finish_narrowphase_modification( messages::modify_msg * );
+
+      void check_broadphase_bounds( check_bounds_msg *_msg );
+      void broadphase( broadphase_msg *_msg );
+
+      void run_narrowphase_batches( narrowphase_batches_msg *_msg );
+      void run_queued_narrowphase( narrowphase_queue_msg *_msg );
     };
 
     using collision_object_proxy_type = ::vt::objgroup::ObjGroupManager::ProxyType< collision_object_holder >;
@@ -192,16 +221,43 @@ namespace bvh
         : collision_object( _coll_obj )
       {}
 
+      /// \brief Record the ghost generation of the current payload, forgetting where the previous
+      /// payload was delivered if it changed
+      void set_generation( std::size_t _generation )
+      {
+        if ( _generation != generation )
+        {
+          generation = _generation;
+          std::fill( delivered_destinations.begin(), delivered_destinations.end(), 0 );
+        }
+      }
+
+      /// \brief Mark the payload as delivered to `_node`
+      ///
+      /// \return whether it was not delivered to `_node` before
+      bool mark_delivered( ::vt::NodeType _node )
+      {
+        const auto n = static_cast< std::size_t >( _node );
+        if ( n >= delivered_destinations.size() )
+          delivered_destinations.resize( ::vt::theContext()->getNumNodes(), 0 );
+        if ( delivered_destinations[n] )
+          return false;
+        delivered_destinations[n] = 1;
+        return true;
+      }
+
       patch<> patch_meta;
       std::vector< unsigned char > bytes;
+      std::vector< unsigned char > tree_bytes; ///< Serialized element tree of the patch, empty if not built
       ::vt::NodeType origin_node = ::vt::uninitialized_destination;
-      std::unordered_set< ::vt::NodeType > ghost_destinations;
+      std::vector< unsigned char > delivered_destinations; ///< Per node, whether this payload was already ghosted to it
+      std::size_t generation = 0; ///< Ghost generation of the object that `bytes` was set in
       collision_object_proxy_type collision_object;
 
       template< typename Serializer > void serialize( Serializer &_s )
       {
         MessageParentType::serialize( _s );
-        _s | patch_meta | bytes | origin_node | ghost_destinations | collision_object;
+        _s | patch_meta | bytes | tree_bytes | origin_node | delivered_destinations | generation | collision_object;
       }
     };
 
@@ -211,6 +267,8 @@ namespace bvh
       patch<> patch_meta;
       ::vt::NodeType origin_node = ::vt::uninitialized_destination;
       std::size_t data_size = 0;
+      std::size_t tree_size = 0;
+      std::size_t generation = 0;
 
       // Used with makeMessageSz, invalid otherwise!
       unsigned char *user_data()
@@ -222,6 +280,10 @@ namespace bvh
       {
         return reinterpret_cast< const unsigned char * >( this ) + sizeof( narrowphase_patch_msg );
       }
+
+      // The serialized element tree follows the user data
+      unsigned char *tree_data() { return user_data() + data_size; }
+      const unsigned char *tree_data() const { return user_data() + data_size; }
     };
 
     /**
@@ -269,9 +331,6 @@ namespace bvh
       collision_object_proxy_type other_obj;
     };
 
-    struct start_narrowphase_msg : ::vt::CollectionMessage< collision_object_impl::narrowphase_collection_type >
-    { };
-
     struct clear_narrowphase_msg : ::vt::CollectionMessage< collision_object_impl::narrowphase_collection_type >
     { };
 
@@ -282,6 +341,7 @@ namespace bvh
 
       patch<> meta;
       std::vector< unsigned char > patch_data;
+      std::vector< unsigned char > tree_data;
       ::vt::NodeType origin_node;
       vt_index idx;
 
@@ -299,13 +359,35 @@ namespace bvh
       void serialize( Serializer &_s )
       {
         MessageParentType::serialize( _s );
-        _s | meta | patch_data | origin_node | idx;
+        _s | meta | patch_data | tree_data | origin_node | idx;
       }
     };
 
     struct active_narrowphase_local_index_msg : ::vt::CollectionMessage< collision_object_impl::narrowphase_collection_type >
     {
       vt_index idx;
+      bool count_pair = true;  ///< Whether to count the pair for the patch, false for the second side of a patch with itself
+    };
+
+    struct check_bounds_msg : ::vt::Message
+    {
+      collision_object_proxy_type other_obj;
+    };
+
+    struct broadphase_msg : ::vt::Message
+    {
+      collision_object_proxy_type other_obj;
+      broadphase_orientation orientation = broadphase_orientation::this_patches;
+    };
+
+    struct narrowphase_batches_msg : ::vt::Message
+    {
+      collision_object_proxy_type other_obj;
+    };
+
+    struct narrowphase_queue_msg : ::vt::Message
+    {
+      collision_object_proxy_type other_obj;
     };
 
   } // namespace collision_object_impl
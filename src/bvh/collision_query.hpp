@@ -36,6 +36,8 @@
 #include <vector>
 #include <functional>
 #include <cstring>
+#include <iterator>
+#include <utility>
 #include "traits.hpp"
 #include "util/span.hpp"
 #include "patch.hpp"
@@ -57,10 +59,22 @@ namespace bvh
         : object(_object), meta( _meta ), patch_id(_patch_id), elements(_elements)
     {}
 
+    broadphase_collision(collision_object &_object,
+                         const patch<> &_meta,
+                         std::size_t _patch_id,
+                         span<const T> _elements,
+                         span< const std::pair< std::size_t, std::size_t > > _element_candidates)
+        : object(_object), meta( _meta ), patch_id(_patch_id), elements(_elements),
+          element_candidates( _element_candidates )
+    {}
+
     collision_object &object;
     patch<> meta;
     std::size_t patch_id;
     span< const T > elements;
+    /// Pairs of (index in the first patch's elements, index in the second patch's elements) whose bounds overlap.
+    /// Only set when both objects build element trees, see `collision_object::set_element_trees`
+    span< const std::pair< std::size_t, std::size_t > > element_candidates;
   };
 
   class narrowphase_result
@@ -160,6 +174,13 @@ namespace bvh
     narrowphase_result b;
   };
 
+  /// Results of a batched narrowphase call, see `collision_world::set_narrowphase_batch_functor`
+  struct narrowphase_batch_result
+  {
+    narrowphase_result primary;                 ///< Sent to the rank owning the primary patch
+    std::vector< narrowphase_result > partners; ///< Empty, or one per partner patch sent to the rank owning it
+  };
+
 
   namespace detail
   {
@@ -378,6 +399,76 @@ namespace bvh
     return ret;
   }
 
+  namespace detail
+  {
+    template< typename NodeType, typename LeftLeafs, typename RightLeafs, typename OutputIterator, typename Filter >
+    void
+    get_overlapping_local_indices( const NodeType *_left,
+                                   const NodeType *_right,
+                                   const LeftLeafs &_left_leafs,
+                                   const RightLeafs &_right_leafs,
+                                   OutputIterator &_iter,
+                                   Filter &_filter )
+    {
+      if ( !_left || !_right || !overlap( _left->kdop(), _right->kdop() ) )
+        return;
+
+      if ( _left->is_leaf() && _right->is_leaf() )
+      {
+        // Leaves may hold several elements, test them individually
+        for ( std::size_t i = _left->get_patch()[0]; i < _left->get_patch()[1]; ++i )
+          for ( std::size_t j = _right->get_patch()[0]; j < _right->get_patch()[1]; ++j )
+            if ( _filter( _left_leafs[i], _right_leafs[j] ) && overlap( _left_leafs[i].kdop(), _right_leafs[j].kdop() ) )
+              *_iter++ = std::make_pair( _left_leafs[i].local_index(), _right_leafs[j].local_index() );
+      } else if ( _left->is_leaf() ) {
+        if ( _right->has_left() )
+          get_overlapping_local_indices< NodeType >( _left, _right->left(), _left_leafs, _right_leafs, _iter, _filter );
+        if ( _right->has_right() )
+          get_overlapping_local_indices< NodeType >( _left, _right->right(), _left_leafs, _right_leafs, _iter, _filter );
+      } else {
+        if ( _left->has_left() )
+          get_overlapping_local_indices< NodeType >( _left->left(), _right, _left_leafs, _right_leafs, _iter, _filter );
+        if ( _left->has_right() )
+          get_overlapping_local_indices< NodeType >( _left->right(), _right, _left_leafs, _right_leafs, _iter, _filter );
+      }
+    }
+  }
+
+  /**
+   * Find the pairs of leafs of two trees whose bounds overlap, identified by the `local_index()` of the leafs.
+   *
+   * \param _lhs      the left tree
+   * \param _rhs      the right tree
+   * \param _pairs    the container the (left local index, right local index) pairs are appended to
+   */
+  template< typename TreeType, typename Container >
+  void
+  overlapping_local_indices( const TreeType &_lhs, const TreeType &_rhs, Container &_pairs )
+  {
+    auto iter = std::back_inserter( _pairs );
+    auto all = []( const auto &, const auto & ) { return true; };
+    detail::get_overlapping_local_indices< typename TreeType::node_type >( _lhs.root(), _rhs.root(), _lhs.leafs(),
+                                                                           _rhs.leafs(), iter, all );
+  }
+
+  /**
+   * Find the pairs of leafs of two trees whose bounds overlap and that are accepted by a filter, identified by
+   * the `local_index()` of the leafs. The filter is tested before the bounds.
+   *
+   * \param _lhs      the left tree
+   * \param _rhs      the right tree
+   * \param _pairs    the container the (left local index, right local index) pairs are appended to
+   * \param _filter   callable taking a left and a right leaf, returns whether the pair is considered
+   */
+  template< typename TreeType, typename Container, typename Filter >
+  void
+  overlapping_local_indices( const TreeType &_lhs, const TreeType &_rhs, Container &_pairs, Filter &&_filter )
+  {
+    auto iter = std::back_inserter( _pairs );
+    detail::get_overlapping_local_indices< typename TreeType::node_type >( _lhs.root(), _rhs.root(), _lhs.leafs(),
+                                                                           _rhs.leafs(), iter, _filter );
+  }
+
 #if 0
   namespace detail
   {
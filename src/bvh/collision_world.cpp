@@ -57,11 +57,16 @@ namespace bvh
     m_impl->collision_world_logger->trace( "Initialized collision object narrowphase logger" );
 
     m_impl->overdecomposition = _overdecomposition_factor;
+    m_impl->in_process = _cfg.in_process && ::vt::theContext()->getNumNodes() == 1;
+    m_impl->parallel_broadphase = _cfg.parallel_broadphase;
+    m_impl->parallel_narrowphase = _cfg.parallel_narrowphase;
+    m_impl->compact_tree_messages = _cfg.compact_tree_messages;
     auto user_event_name = "bvh_impl_functor_";
     m_impl->bvh_impl_functor_ = ::vt::theTrace()->registerUserEventColl( user_event_name);
     m_impl->collision_world_logger->trace( "registered user tracing event {}", user_event_name );
 
-    m_impl->collision_world_logger->info( "Initialized collision world with overdecomposition factor {}", _overdecomposition_factor );
+    m_impl->collision_world_logger->info( "Initialized collision world with overdecomposition factor {}{}", _overdecomposition_factor,
+                                          m_impl->in_process ? ", running in-process" : "" );
   }
 
   collision_world::~collision_world() = default;
@@ -74,9 +79,42 @@ namespace bvh
   {
     std::size_t idx = m_impl->collision_objects.size();
     // Use new allocator here because of private collision_object constructor
-    m_impl->collision_objects.emplace_back( new collision_object( *this, idx, m_impl->overdecomposition ) );
+    auto &obj = *m_impl->collision_objects.emplace_back( new collision_object( *this, idx, m_impl->overdecomposition ) );
 
-    return *m_impl->collision_objects.back();
+    // Initialize objgroup for per-node data
+    ::vt::runInEpochCollective( "collision_object.make_objgroup", [&obj](){ obj.make_objgroup(); } );
+
+    return obj;
+  }
+
+  std::vector< std::reference_wrapper< collision_object > >
+  collision_world::create_collision_objects( std::size_t _count )
+  {
+    const std::size_t first = m_impl->collision_objects.size();
+    std::vector< std::reference_wrapper< collision_object > > ret;
+    ret.reserve( _count );
+    for ( std::size_t i = 0; i < _count; ++i )
+      ret.emplace_back( *m_impl->collision_objects.emplace_back( new collision_object( *this, first + i, m_impl->overdecomposition ) ) );
+
+    // Every objgroup is created in the same epoch
+    ::vt::runInEpochCollective( "collision_world.make_objgroups", [&ret](){
+      for ( auto &&obj : ret )
+        obj.get().make_objgroup();
+    } );
+
+    // The collections are only used by the distributed pipeline
+    if ( !m_impl->in_process )
+    {
+      std::vector< ::vt::EpochType > pending;
+      for ( auto &&obj : ret )
+        obj.get().make_collections( pending );
+      for ( auto &&epoch : pending )
+        ::vt::runSchedulerThrough( epoch );
+    }
+
+    m_impl->collision_world_logger->info( "created {} collision objects", _count );
+
+    return ret;
   }
 
   std::size_t
@@ -91,10 +129,24 @@ namespace bvh
     return m_impl->overdecomposition;
   }
 
+  bool
+  collision_world::in_process() const noexcept
+  {
+    return m_impl->in_process;
+  }
+
   void
   collision_world::set_narrowphase_functor_impl( internal_narrowphase_functor &&_fun )
   {
     m_impl->functor = std::move( _fun );
+    m_impl->batch_functor = nullptr;
+  }
+
+  void
+  collision_world::set_narrowphase_batch_functor_impl( internal_narrowphase_batch_functor &&_fun )
+  {
+    m_impl->batch_functor = std::move( _fun );
+    m_impl->functor = nullptr;
   }
 
   void
@@ -102,6 +154,9 @@ namespace bvh
   {
     m_impl->epoch = ::vt::theTerm()->makeEpochCollective( "iteration" );
 
+    if ( m_impl->capture )
+      m_impl->capture->begin_iteration();
+
     ::vt::theMsg()->pushEpoch( m_impl->epoch );
   }
 
@@ -122,6 +177,31 @@ namespace bvh
     ::vt::thePhase()->nextPhaseCollective();
 
     m_impl->epoch = ::vt::no_epoch;
+
+    if ( m_impl->capture )
+      m_impl->capture->end_iteration();
+  }
+
+  void
+  collision_world::start_capture( const std::string &_prefix )
+  {
+    const auto rank = static_cast< std::uint32_t >( ::vt::theContext()->getNode() );
+    const auto num_ranks = static_cast< std::uint32_t >( ::vt::theContext()->getNumNodes() );
+    const auto path = capture_file_path( _prefix, rank );
+    m_impl->capture = std::make_unique< capture_writer >( path, rank, num_ranks, m_impl->overdecomposition );
+    m_impl->collision_world_logger->info( "capturing collision world inputs to {}", path );
+  }
+
+  void
+  collision_world::stop_capture()
+  {
+    m_impl->capture.reset();
+  }
+
+  capture_writer *
+  collision_world::capture() const noexcept
+  {
+    return m_impl->capture.get();
   }
 
   std::shared_ptr< spdlog::logger >
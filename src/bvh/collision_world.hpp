@@ -35,6 +35,8 @@
 
 #include <vector>
 #include <memory>
+#include <string>
+#include <functional>
 #include "collision_query.hpp"
 #include "snapshot.hpp"
 #include "util/functional.hpp"
@@ -44,11 +46,37 @@
 namespace bvh
 {
   class collision_object;
+  class capture_writer;
+
+  namespace detail
+  {
+    /// Type-erased partner patch of a batched narrowphase call
+    struct narrowphase_batch_partner
+    {
+      const patch<> *meta;
+      const void *data;
+      std::size_t size;
+      span< const std::pair< std::size_t, std::size_t > > element_candidates;
+    };
+  }
 
   struct world_config
   {
-    spdlog::level::level_enum log_levels = spdlog::level::trace;
+    /// Runtime log level, messages below the compile time floor `BVH_LOG_ACTIVE_LEVEL` are never logged
+    spdlog::level::level_enum log_levels = spdlog::level::warn;
     spdlog::level::level_enum flush_level = spdlog::level::trace;
+    /// Take the single rank fast path, see `collision_world::in_process`. Opt-in, ignored on more than one rank
+    bool in_process = false;
+    /// Query all local patches of a broadphase against the tree in one Kokkos `parallel_for` on the host, instead
+    /// of one scheduler handler per patch, so multicore ranks use all their cores
+    bool parallel_broadphase = false;
+    /// Queue the narrowphase pairs of a rank once their patches are available and run them in one Kokkos
+    /// `parallel_for` on the host. The functor set with `set_narrowphase_functor` must be reentrant. A batch
+    /// functor runs as before
+    bool parallel_narrowphase = false;
+    /// Broadcast the patch tree of each broadphase in `compact_snapshot_tree` form, with quantized bounds that are
+    /// rounded outward, instead of with full precision bounds and snapshots
+    bool compact_tree_messages = false;
   };
 
   class collision_world
@@ -58,6 +86,9 @@ namespace bvh
     template< typename T >
     using narrowphase_functor = std::function< narrowphase_result_pair( const broadphase_collision< T > &, const broadphase_collision< T > & ) >;
 
+    template< typename T >
+    using narrowphase_batch_functor = std::function< narrowphase_batch_result( const broadphase_collision< T > &, span< const broadphase_collision< T > > ) >;
+
     explicit collision_world( std::size_t _overdecomposition_factor, const world_config &_cfg = {} );
     ~collision_world();
 
@@ -69,14 +100,34 @@ namespace bvh
 
     collision_object &create_collision_object();
 
+    /// \brief Create many collision objects at once
+    ///
+    /// Equivalent to calling `create_collision_object` `_count` times, but the objgroups of all the objects
+    /// are created in a single collective epoch and their collections are constructed together instead of
+    /// lazily in the first `init_broadphase`. Must be called collectively.
+    ///
+    /// \param[in] _count  the number of objects to create
+    /// \return the new objects, in order of their ids
+    std::vector< std::reference_wrapper< collision_object > > create_collision_objects( std::size_t _count );
+
     std::size_t num_collision_objects() const noexcept;
     std::size_t overdecomposition_factor() const noexcept;
 
+    /// \brief Whether the broadphase and narrowphase take the single rank fast path
+    ///
+    /// On a single rank with `world_config::in_process` set, trees are built and pairs are found and passed
+    /// to the narrowphase functor directly, skipping the collections, ghosting and result messages of the
+    /// distributed pipeline. The local patches are queried in a Kokkos `parallel_for` on the host.
+    /// `init_broadphase` and `broadphase` then finish their work before returning; the results are the same.
+    /// The world is still constructed with vt, which has to be initialized.
+    bool in_process() const noexcept;
+
     template< typename T >
     void set_narrowphase_functor( narrowphase_functor< T > _fun )
     {
       set_narrowphase_functor_impl( [_fun]( collision_object &_first, const patch<> &_ma, std::size_t _first_patch_id, const void *_first_patch, std::size_t _first_patch_size,
-                                           collision_object &_second, const patch<> &_mb,  std::size_t _second_patch_id, const void *_second_patch, std::size_t _second_patch_size ) {
+                                           collision_object &_second, const patch<> &_mb,  std::size_t _second_patch_id, const void *_second_patch, std::size_t _second_patch_size,
+                                           span< const std::pair< std::size_t, std::size_t > > _candidates ) {
         const T *first_elms = static_cast< const T * >( _first_patch );
         const T *second_elms = static_cast< const T * >( _second_patch );
 
@@ -84,18 +135,66 @@ namespace bvh
         assert( _second_patch_id == _mb.global_id() );
 
         broadphase_collision< T > first{ _first, _ma, _first_patch_id,
-              span< const T >( first_elms, _first_patch_size / sizeof( T ) ) };
+              span< const T >( first_elms, _first_patch_size / sizeof( T ) ), _candidates };
 
         broadphase_collision< T > second{ _second, _mb, _second_patch_id,
-              span< const T >( second_elms, _second_patch_size / sizeof( T ) ) };
+              span< const T >( second_elms, _second_patch_size / sizeof( T ) ), _candidates };
 
         return _fun( first, second );
       } );
     }
 
+    /// \brief Set a narrowphase functor that is called once per patch with all the patches colliding with it
+    ///
+    /// For every patch of a collision object, the functor receives the patch and all the patches of the other
+    /// object that it collides with on this rank, so per-patch work like building acceleration structures is
+    /// done once per rank instead of once per pair. The element candidates of each pair are on the partner patches.
+    /// This replaces a functor set with `set_narrowphase_functor` and must be set before `broadphase` is called.
+    ///
+    /// Batches are per rank and may be partial: a pair runs on the rank that found it in the broadphase, which
+    /// depends on the `broadphase_orientation`. With several ranks, a patch whose pairs were found on different
+    /// ranks is passed to the functor once on each of them, each time with only the partners found there.
+    ///
+    /// \tparam T      the narrowphase element type
+    /// \param[in] _fun the functor
+    template< typename T >
+    void set_narrowphase_batch_functor( narrowphase_batch_functor< T > _fun )
+    {
+      set_narrowphase_batch_functor_impl( [_fun]( collision_object &_first, const patch<> &_meta, const void *_patch, std::size_t _patch_size,
+                                                 collision_object &_second, span< const detail::narrowphase_batch_partner > _partners ) {
+        broadphase_collision< T > first{ _first, _meta, _meta.global_id(),
+              span< const T >( static_cast< const T * >( _patch ), _patch_size / sizeof( T ) ) };
+
+        std::vector< broadphase_collision< T > > partners;
+        partners.reserve( _partners.size() );
+        for ( auto &&p : _partners )
+          partners.emplace_back( _second, *p.meta, p.meta->global_id(),
+                                 span< const T >( static_cast< const T * >( p.data ), p.size / sizeof( T ) ),
+                                 p.element_candidates );
+
+        return _fun( first, span< const broadphase_collision< T > >( partners.data(), partners.size() ) );
+      } );
+    }
+
     void start_iteration();
     void finish_iteration();
 
+    /// \brief Capture the inputs of every collision object for offline replay
+    ///
+    /// From now on, iterations and the `set_entity_data`, `init_broadphase` and `broadphase` calls of every
+    /// collision object are written to the per-rank file `capture_file_path( _prefix, rank )`. The elements are
+    /// captured as their snapshots, see `capture_writer`. `examples/replay_capture.cpp` feeds a capture back
+    /// through the library with a stand-in narrowphase.
+    ///
+    /// \param[in] _prefix  path prefix of the capture files
+    void start_capture( const std::string &_prefix );
+
+    /// \brief Stop capturing and close the capture file
+    void stop_capture();
+
+    /// \brief The active capture, or `nullptr` if not capturing
+    capture_writer *capture() const noexcept;
+
     std::shared_ptr< spdlog::logger > collision_object_logger() const;
     std::shared_ptr< spdlog::logger > collision_object_broadphase_logger() const;
     std::shared_ptr< spdlog::logger > collision_object_narrowphase_logger() const;
@@ -107,9 +206,15 @@ namespace bvh
     friend impl &get_impl( collision_world &_world );
 
     using internal_narrowphase_functor
-        = std::function< narrowphase_result_pair( collision_object &, const patch<> &, std::size_t, const void *, std::size_t, collision_object &, const patch<> &, std::size_t, const void *, std::size_t ) >;
+        = std::function< narrowphase_result_pair( collision_object &, const patch<> &, std::size_t, const void *, std::size_t, collision_object &, const patch<> &, std::size_t, const void *, std::size_t,
+                                                  span< const std::pair< std::size_t, std::size_t > > ) >;
     void set_narrowphase_functor_impl( internal_narrowphase_functor &&_fun );
 
+    using internal_narrowphase_batch_functor
+        = std::function< narrowphase_batch_result( collision_object &, const patch<> &, const void *, std::size_t, collision_object &,
+                                                   span< const detail::narrowphase_batch_partner > ) >;
+    void set_narrowphase_batch_functor_impl( internal_narrowphase_batch_functor &&_fun );
+
     std::unique_ptr< impl > m_impl;
   };
 }
@@ -34,6 +34,8 @@
 #define INC_BVH_COLLISION_WORLD_IMPL_HPP
 
 #include "../collision_world.hpp"
+#include "narrowphase_scheduler.hpp"
+#include "../capture.hpp"
 #include <vt/transport.h>
 #include <vt/trace/trace_common.h>
 
@@ -57,10 +59,20 @@ namespace bvh
     std::vector< std::unique_ptr< collision_object > > collision_objects;
 
     collision_world::internal_narrowphase_functor functor;
+    collision_world::internal_narrowphase_batch_functor batch_functor; ///< Takes precedence over `functor` if set
 
     std::size_t overdecomposition = 2;
+    bool in_process = false; ///< Single rank, see `collision_world::in_process`
+    bool parallel_broadphase = false; ///< See `world_config::parallel_broadphase`
+    bool parallel_narrowphase = false; ///< See `world_config::parallel_narrowphase`
+    bool compact_tree_messages = false; ///< See `world_config::compact_tree_messages`
     ::vt::EpochType epoch;
 
+    /// Narrowphase pair tasks on this rank waiting for their ghosted patches
+    collision_world_impl::narrowphase_scheduler narrowphase_scheduler;
+
+    std::unique_ptr< capture_writer > capture;
+
     ::vt::trace::UserEventIDType bvh_impl_functor_ = ::vt::trace::no_user_event_id;
 
     std::shared_ptr< spdlog::logger > collision_world_logger;
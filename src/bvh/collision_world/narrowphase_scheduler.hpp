@@ -0,0 +1,133 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef INC_BVH_COLLISION_WORLD_NARROWPHASE_SCHEDULER_HPP
+#define INC_BVH_COLLISION_WORLD_NARROWPHASE_SCHEDULER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+#include "../util/span.hpp"
+
+namespace bvh
+{
+  namespace collision_world_impl
+  {
+    /**
+     * Per-rank dependency counting scheduler for narrowphase pair tasks.
+     *
+     * A task depends on the payloads of the two patches of its pair. Tasks whose payloads are all present
+     * (local or already cached) run as soon as they are added, the rest run from the handler that delivers
+     * their last missing payload, so narrowphase work overlaps with the ghosting of other patches.
+     */
+    class narrowphase_scheduler
+    {
+    public:
+
+      using task_function = std::function< void() >;
+
+      /// (collision object id, global patch id)
+      using payload_key = std::pair< std::size_t, std::size_t >;
+
+      /**
+       * Add a task. If no payloads are missing it is run immediately.
+       *
+       * \param _missing  the payloads that have not arrived on this rank yet, without duplicates
+       * \param _task     the task to run once all of them arrived
+       */
+      void add_task( span< const payload_key > _missing, task_function _task )
+      {
+        if ( _missing.empty() )
+        {
+          _task();
+          return;
+        }
+
+        const auto id = m_tasks.size();
+        m_tasks.push_back( task{ _missing.size(), std::move( _task ) } );
+        ++m_num_pending;
+        for ( auto &&key : _missing )
+          m_waiting[key].push_back( id );
+      }
+
+      /**
+       * Signal that a payload arrived on this rank, running every task that was only waiting on it.
+       * Must be called once per payload.
+       *
+       * \param _key  the payload that arrived
+       */
+      void payload_ready( const payload_key &_key )
+      {
+        auto it = m_waiting.find( _key );
+        if ( it == m_waiting.end() )
+          return;
+
+        auto waiting = std::move( it->second );
+        m_waiting.erase( it );
+
+        for ( auto &&id : waiting )
+        {
+          auto &t = m_tasks[id];
+          if ( --t.remaining == 0 )
+          {
+            auto fun = std::move( t.fun );
+            --m_num_pending;
+            fun();
+          }
+        }
+
+        // Every task ran, recycle the storage
+        if ( m_num_pending == 0 )
+          m_tasks.clear();
+      }
+
+      /// \brief The number of tasks still waiting on a payload
+      std::size_t num_pending() const noexcept { return m_num_pending; }
+
+    private:
+
+      struct task
+      {
+        std::size_t remaining;
+        task_function fun;
+      };
+
+      std::vector< task > m_tasks;
+      std::map< payload_key, std::vector< std::size_t > > m_waiting;
+      std::size_t m_num_pending = 0;
+    };
+  }
+}
+
+#endif  // INC_BVH_COLLISION_WORLD_NARROWPHASE_SCHEDULER_HPP
@@ -0,0 +1,69 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef INC_BVH_FILE_EXCEPTION_HPP
+#define INC_BVH_FILE_EXCEPTION_HPP
+
+#include "exception.hpp"
+#include <sstream>
+
+namespace bvh
+{
+  /// Base of the exceptions for files written by distBVH that can't be used, e.g. state, tree or capture files
+  class file_exception : public exception
+  {
+  public:
+
+    file_exception( std::string _path, std::string _kind, std::string _reason )
+      : m_path( std::move( _path ) ), m_kind( std::move( _kind ) ), m_reason( std::move( _reason ) )
+    {}
+
+    std::string message() const override
+    {
+      std::ostringstream oss;
+      oss << "Invalid " << m_kind << " file " << m_path << ": " << m_reason;
+
+      return oss.str();
+    }
+
+    const std::string &path() const noexcept { return m_path; }
+    const std::string &reason() const noexcept { return m_reason; }
+
+  private:
+
+    std::string m_path;
+    std::string m_kind;
+    std::string m_reason;
+  };
+}
+
+#endif  // INC_BVH_FILE_EXCEPTION_HPP
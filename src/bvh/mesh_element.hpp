@@ -0,0 +1,128 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef INC_BVH_MESH_ELEMENT_HPP
+#define INC_BVH_MESH_ELEMENT_HPP
+
+#include <cstddef>
+#include "math/vec.hpp"
+#include "util/array.hpp"
+#include "util/kokkos.hpp"
+#include "snapshot.hpp"
+#include "types.hpp"
+
+namespace bvh
+{
+  /**
+   * The narrowphase payload of an element set from node coordinates and connectivity, see the
+   * `collision_object::set_entity_data` overload taking coordinate and connectivity views.
+   *
+   * \tparam N  the number of nodes per element
+   */
+  template< std::size_t N >
+  struct mesh_element
+  {
+    std::size_t id;
+    array< m::vec3< double >, N > vertices;  ///< Coordinates of the nodes, in connectivity order
+
+    KOKKOS_INLINE_FUNCTION std::size_t global_id() const noexcept { return id; }
+  };
+
+  namespace detail
+  {
+    /**
+     * Snapshot of the element `_i` of a mesh given by views of node coordinates and connectivity. The bounds are
+     * the \f$k\f$-DOP of the nodes and the centroid is the mean of the nodes.
+     *
+     * \param _coordinates   the node coordinates, one row of 3 per node
+     * \param _connectivity  the node indices, one row of `N` per element
+     * \param _global_id     the global id of the element
+     * \param _i             the index of the element in `_connectivity`
+     */
+    template< typename CoordView, typename ConnView >
+    KOKKOS_INLINE_FUNCTION entity_snapshot
+    make_mesh_snapshot( const CoordView &_coordinates, const ConnView &_connectivity, std::size_t _global_id,
+                        std::size_t _i )
+    {
+      using arithmetic_type = bphase_kdop::arithmetic_type;
+      constexpr std::size_t num_nodes = ConnView::static_extent( 1 );
+      static_assert( num_nodes > 0, "the connectivity needs a compile time number of nodes per element" );
+
+      array< m::vec3< arithmetic_type >, num_nodes > v;
+      m::vec3< arithmetic_type > centroid{ 0, 0, 0 };
+      for ( std::size_t n = 0; n < num_nodes; ++n )
+      {
+        const auto node = _connectivity( _i, n );
+        v[n] = m::vec3< arithmetic_type >( _coordinates( node, 0 ), _coordinates( node, 1 ), _coordinates( node, 2 ) );
+        centroid += v[n];
+      }
+      centroid /= static_cast< arithmetic_type >( num_nodes );
+
+      bphase_kdop bounds;
+      const auto &normal_list = bphase_kdop::normals();
+      for ( int a = 0; a < bphase_kdop::num_axis; ++a )
+      {
+        auto proj = bphase_kdop::project( v[0], normal_list[a] );
+        bounds.extents[a].min = proj;
+        bounds.extents[a].max = proj;
+        for ( std::size_t n = 1; n < num_nodes; ++n )
+        {
+          proj = bphase_kdop::project( v[n], normal_list[a] );
+          bounds.extents[a].min = Kokkos::min( bounds.extents[a].min, proj );
+          bounds.extents[a].max = Kokkos::max( bounds.extents[a].max, proj );
+        }
+      }
+
+      return entity_snapshot{ _global_id, bounds, centroid, _i };
+    }
+
+    /**
+     * Narrowphase payload of the element `_i` of a mesh, see \ref make_mesh_snapshot.
+     */
+    template< typename CoordView, typename ConnView >
+    KOKKOS_INLINE_FUNCTION mesh_element< ConnView::static_extent( 1 ) >
+    make_mesh_element( const CoordView &_coordinates, const ConnView &_connectivity, std::size_t _global_id,
+                       std::size_t _i )
+    {
+      mesh_element< ConnView::static_extent( 1 ) > e;
+      e.id = _global_id;
+      for ( std::size_t n = 0; n < ConnView::static_extent( 1 ); ++n )
+      {
+        const auto node = _connectivity( _i, n );
+        e.vertices[n] = m::vec3< double >( _coordinates( node, 0 ), _coordinates( node, 1 ), _coordinates( node, 2 ) );
+      }
+      return e;
+    }
+  }
+}
+
+#endif  // INC_BVH_MESH_ELEMENT_HPP
@@ -220,6 +220,13 @@ namespace bvh
     {
       m_parent_offset = _offset;
     }
+
+    /**
+     * Returns the offset of the parent. Does not convert into a pointer unlike parent().
+     *
+     * eturn          the offset of the parent or 0 if the node is a root
+     */
+    std::ptrdiff_t get_parent_offset() const noexcept { return m_parent_offset; }
     
     /**
      *  Construct a node by moving in a k_DOP and giving a parent node.
@@ -0,0 +1,352 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef INC_BVH_SERIALIZATION_COMPACT_TREE_HPP
+#define INC_BVH_SERIALIZATION_COMPACT_TREE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "../tree.hpp"
+#include "../tree_build.hpp"
+#include "../snapshot.hpp"
+
+namespace bvh
+{
+  namespace detail
+  {
+    /// Number of steps between the bounds of the parent when quantizing a bound to a byte
+    inline constexpr unsigned compact_tree_levels = 255;
+
+    template< typename T >
+    T compact_dequantize( const extent< T > &_parent, unsigned _q ) noexcept
+    {
+      // The top level is exactly the parent bound so the parent is always reachable despite rounding
+      if ( _q >= compact_tree_levels )
+        return _parent.max;
+      return _parent.min + _parent.length() * static_cast< T >( _q ) / static_cast< T >( compact_tree_levels );
+    }
+
+    /// Largest level that doesn't decode above `_v`
+    template< typename T >
+    std::uint8_t compact_quantize_down( const extent< T > &_parent, T _v ) noexcept
+    {
+      const T len = _parent.length();
+      if ( !( len > T{ 0 } ) || !( _v > _parent.min ) )
+        return 0;
+
+      auto q = static_cast< unsigned >( std::min( std::floor( ( _v - _parent.min ) / len * compact_tree_levels ),
+                                                  static_cast< T >( compact_tree_levels ) ) );
+      while ( q > 0 && compact_dequantize( _parent, q ) > _v )
+        --q;
+      return static_cast< std::uint8_t >( q );
+    }
+
+    /// Smallest level that doesn't decode below `_v`
+    template< typename T >
+    std::uint8_t compact_quantize_up( const extent< T > &_parent, T _v ) noexcept
+    {
+      const T len = _parent.length();
+      if ( !( len > T{ 0 } ) || !( _v < _parent.max ) )
+        return static_cast< std::uint8_t >( compact_tree_levels );
+
+      auto q = static_cast< unsigned >( std::max( std::ceil( ( _v - _parent.min ) / len * compact_tree_levels ),
+                                                  T{ 0 } ) );
+      while ( q < compact_tree_levels && compact_dequantize( _parent, q ) < _v )
+        ++q;
+      return static_cast< std::uint8_t >( q );
+    }
+  }
+
+  /**
+   * Compact wire format of a \ref snapshot_tree, used to broadcast the patch-level tree of a collision object.
+   *
+   * Only the root bounds are sent at full precision. Each other node sends one byte per bound, the position of the
+   * bound between the bounds of its parent, rounded outward, and each leaf snapshot is quantized the same way
+   * relative to its leaf node. Leaf ids are sent with the smallest of 2, 4 or 8 bytes that fits every id of the
+   * tree, and centroids with 16 bits per coordinate inside the snapshot bounds. Decoding gives the same nodes and
+   * ids in the same order, with bounds that contain the original ones, so queries on the decoded tree find every
+   * pair the original tree finds.
+   *
+   * Node bounds must contain the bounds of their children and leafs, which every tree built by this library does.
+   */
+  class compact_snapshot_tree
+  {
+  public:
+
+    using kdop_type = snapshot_tree::kdop_type;
+    using arithmetic_type = kdop_type::arithmetic_type;
+    using node_type = snapshot_tree::node_type;
+
+    compact_snapshot_tree() = default;
+
+    /**
+     * Encode a tree.
+     *
+     * \param _tree   the tree to encode
+     */
+    explicit compact_snapshot_tree( const snapshot_tree &_tree )
+    {
+      if ( _tree.empty() )
+        return;
+
+      std::size_t max_id = 0;
+      for ( auto &&l : _tree.leafs() )
+        max_id = std::max( { max_id, l.global_id(), l.local_index() } );
+      m_id_bytes = ( max_id <= 0xffff ) ? 2 : ( max_id <= 0xffffffff ) ? 4 : 8;
+
+      m_num_nodes = _tree.nodes().size();
+      m_num_leafs = _tree.count();
+      m_root = _tree.root()->kdop();
+      m_shape.reserve( m_num_nodes );
+      m_bounds.reserve( ( m_num_nodes - 1 + m_num_leafs ) * kdop_type::k );
+      m_ids.reserve( 2 * m_num_leafs * m_id_bytes );
+      m_centroids.reserve( 3 * m_num_leafs );
+
+      encode_node( *_tree.root(), m_root, _tree.leafs() );
+    }
+
+    /// \brief The number of leaf snapshots of the encoded tree
+    std::size_t count() const noexcept { return m_num_leafs; }
+
+    /// \brief Whether the encoded tree is empty
+    bool empty() const noexcept { return m_num_nodes == 0; }
+
+    /**
+     * Decode the tree. The bounds of every node and snapshot contain the bounds of the encoded tree.
+     *
+     * \return the decoded tree
+     */
+    snapshot_tree decode() const
+    {
+      dynarray< entity_snapshot > leafs;
+      dynarray< node_type > nodes;
+      if ( empty() )
+        return snapshot_tree{};
+
+      leafs.reserve( m_num_leafs );
+      nodes.reserve( m_num_nodes );
+
+      cursor c;
+      decode_node( c, 0, m_root, true, leafs, nodes );
+
+      return snapshot_tree{ std::move( leafs ), std::move( nodes ) };
+    }
+
+    template< typename Serializer >
+    void serialize( Serializer &_s )
+    {
+      _s | m_num_nodes | m_num_leafs | m_id_bytes | m_root | m_shape | m_bounds | m_ids | m_centroids;
+    }
+
+  private:
+
+    /// Positions of the decoder in the encoded arrays
+    struct cursor
+    {
+      std::size_t shape = 0;
+      std::size_t bounds = 0;
+      std::size_t ids = 0;
+      std::size_t centroids = 0;
+    };
+
+    /// Shape entry of an inner node
+    static constexpr std::uint8_t shape_inner = 0xff;
+    /// Leaf nodes hold at most this many snapshots per shape entry, larger leafs continue in the next entries
+    static constexpr std::uint8_t max_shape_count = 0x7e;
+    static constexpr std::uint8_t shape_continues = 0x80;
+
+    void encode_bounds( const kdop_type &_bounds, const kdop_type &_parent, kdop_type &_decoded )
+    {
+      for ( int a = 0; a < kdop_type::num_axis; ++a )
+      {
+        const auto &p = _parent.extents[a];
+        const auto qmin = detail::compact_quantize_down( p, _bounds.extents[a].min );
+        const auto qmax = detail::compact_quantize_up( p, _bounds.extents[a].max );
+        m_bounds.push_back( qmin );
+        m_bounds.push_back( qmax );
+        _decoded.extents[a].min = detail::compact_dequantize( p, qmin );
+        _decoded.extents[a].max = detail::compact_dequantize( p, qmax );
+      }
+    }
+
+    kdop_type decode_bounds( cursor &_c, const kdop_type &_parent ) const
+    {
+      kdop_type ret;
+      for ( int a = 0; a < kdop_type::num_axis; ++a )
+      {
+        const auto &p = _parent.extents[a];
+        ret.extents[a].min = detail::compact_dequantize( p, m_bounds[_c.bounds++] );
+        ret.extents[a].max = detail::compact_dequantize( p, m_bounds[_c.bounds++] );
+      }
+      return ret;
+    }
+
+    void encode_id( std::size_t _id )
+    {
+      const auto at = m_ids.size();
+      m_ids.resize( at + m_id_bytes );
+      if ( m_id_bytes == 2 )
+      {
+        const auto v = static_cast< std::uint16_t >( _id );
+        std::memcpy( m_ids.data() + at, &v, sizeof( v ) );
+      } else if ( m_id_bytes == 4 ) {
+        const auto v = static_cast< std::uint32_t >( _id );
+        std::memcpy( m_ids.data() + at, &v, sizeof( v ) );
+      } else {
+        const auto v = static_cast< std::uint64_t >( _id );
+        std::memcpy( m_ids.data() + at, &v, sizeof( v ) );
+      }
+    }
+
+    std::size_t decode_id( cursor &_c ) const
+    {
+      const auto *p = m_ids.data() + _c.ids;
+      _c.ids += m_id_bytes;
+      if ( m_id_bytes == 2 )
+      {
+        std::uint16_t v;
+        std::memcpy( &v, p, sizeof( v ) );
+        return v;
+      } else if ( m_id_bytes == 4 ) {
+        std::uint32_t v;
+        std::memcpy( &v, p, sizeof( v ) );
+        return v;
+      }
+      std::uint64_t v;
+      std::memcpy( &v, p, sizeof( v ) );
+      return static_cast< std::size_t >( v );
+    }
+
+    void encode_node( const node_type &_node, const kdop_type &_decoded, const dynarray< entity_snapshot > &_leafs )
+    {
+      if ( !_node.is_leaf() )
+      {
+        m_shape.push_back( shape_inner );
+        for ( int c = 0; c < 2; ++c )
+        {
+          kdop_type child;
+          encode_bounds( _node.get_child( c )->kdop(), _decoded, child );
+          encode_node( *_node.get_child( c ), child, _leafs );
+        }
+        return;
+      }
+
+      auto n = _node.num_patch_elements();
+      do
+      {
+        const auto chunk = std::min< std::size_t >( n, max_shape_count );
+        n -= chunk;
+        m_shape.push_back( static_cast< std::uint8_t >( chunk | ( n > 0 ? shape_continues : 0 ) ) );
+      } while ( n > 0 );
+
+      for ( std::size_t i = _node.get_patch()[0]; i < _node.get_patch()[1]; ++i )
+      {
+        const auto &snap = _leafs[i];
+        kdop_type bounds;
+        encode_bounds( snap.kdop(), _decoded, bounds );
+        encode_id( snap.global_id() );
+        encode_id( snap.local_index() );
+
+        const auto centroid = snap.centroid();
+        for ( int d = 0; d < 3; ++d )
+        {
+          const auto &e = bounds.extents[d];
+          const auto t = ( e.length() > 0 ) ? ( centroid[d] - e.min ) / e.length() : 0;
+          m_centroids.push_back( static_cast< std::uint16_t >(
+            std::lround( std::min( std::max( static_cast< double >( t ), 0.0 ), 1.0 ) * 0xffff ) ) );
+        }
+      }
+    }
+
+    /// Decode the subtree at the shape cursor into `_nodes` and return the index of its root
+    std::size_t decode_node( cursor &_c, std::size_t _parent, const kdop_type &_bounds, bool _root,
+                             dynarray< entity_snapshot > &_leafs, dynarray< node_type > &_nodes ) const
+    {
+      const auto idx = _nodes.size();
+      _nodes.emplace_back( kdop_type( _bounds ),
+                           _root ? 0 : static_cast< std::ptrdiff_t >( _parent ) - static_cast< std::ptrdiff_t >( idx ) );
+
+      if ( m_shape[_c.shape] == shape_inner )
+      {
+        ++_c.shape;
+        for ( int c = 0; c < 2; ++c )
+        {
+          const auto child = decode_node( _c, idx, decode_bounds( _c, _bounds ), false, _leafs, _nodes );
+          _nodes[idx].set_child_offset( c, static_cast< std::ptrdiff_t >( child - idx ) );
+        }
+        return idx;
+      }
+
+      std::size_t n = 0;
+      std::uint8_t s;
+      do
+      {
+        s = m_shape[_c.shape++];
+        n += s & ~shape_continues;
+      } while ( s & shape_continues );
+
+      const auto first = _leafs.size();
+      for ( std::size_t i = 0; i < n; ++i )
+      {
+        const auto bounds = decode_bounds( _c, _bounds );
+        const auto gid = decode_id( _c );
+        const auto lid = decode_id( _c );
+
+        entity_snapshot::centroid_type centroid;
+        for ( int d = 0; d < 3; ++d )
+        {
+          const auto &e = bounds.extents[d];
+          centroid[d] = e.min + e.length() * static_cast< arithmetic_type >( m_centroids[_c.centroids++] ) / 0xffff;
+        }
+
+        _leafs.emplace_back( gid, bounds, centroid, lid );
+      }
+      _nodes[idx].set_patch( first, _leafs.size() );
+
+      return idx;
+    }
+
+    std::size_t m_num_nodes = 0;
+    std::size_t m_num_leafs = 0;
+    std::uint8_t m_id_bytes = 2;
+    kdop_type m_root;
+    std::vector< std::uint8_t > m_shape;  ///< Pre-order, `shape_inner` or the snapshot count of a leaf
+    std::vector< std::uint8_t > m_bounds;
+    std::vector< std::uint8_t > m_ids;
+    std::vector< std::uint16_t > m_centroids;
+  };
+}
+
+#endif  // INC_BVH_SERIALIZATION_COMPACT_TREE_HPP
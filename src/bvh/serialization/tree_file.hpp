@@ -0,0 +1,340 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef INC_BVH_SERIALIZATION_TREE_FILE_HPP
+#define INC_BVH_SERIALIZATION_TREE_FILE_HPP
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../tree.hpp"
+#include "../util/span.hpp"
+#include "../exceptions/tree_file_exception.hpp"
+
+namespace bvh
+{
+  /**
+   * Header of the on-disk tree format written by \ref write_tree_file.
+   *
+   * The header is followed by the node array and the leaf array of the tree, each starting at a multiple of
+   * `tree_file_alignment` bytes from the start of the file. Nodes reference their parent and children by offsets
+   * relative to themselves, and the leafs they hold by offsets into the leaf array, so the file is position
+   * independent and can be queried where it is mapped.
+   */
+  struct tree_file_header
+  {
+    std::array< char, 8 > magic;
+    std::uint32_t version;
+    std::uint32_t byte_order;  ///< `tree_file_byte_order` as written by the host that wrote the file
+    std::uint64_t node_size;
+    std::uint64_t leaf_size;
+    std::uint64_t num_nodes;
+    std::uint64_t num_leafs;
+    std::uint64_t nodes_offset;
+    std::uint64_t leafs_offset;
+  };
+
+  inline constexpr std::array< char, 8 > tree_file_magic{ 'D', 'B', 'V', 'H', 'T', 'R', 'E', 'E' };
+  inline constexpr std::uint32_t tree_file_version = 1;
+  inline constexpr std::uint32_t tree_file_byte_order = 0x01020304;
+  inline constexpr std::uint64_t tree_file_alignment = 64;
+
+  namespace detail
+  {
+    inline std::uint64_t tree_file_align( std::uint64_t _offset )
+    {
+      return ( ( _offset + tree_file_alignment - 1 ) / tree_file_alignment ) * tree_file_alignment;
+    }
+
+    inline void tree_file_pad( std::ofstream &_out, std::uint64_t _from, std::uint64_t _to )
+    {
+      static constexpr std::array< char, tree_file_alignment > zeros{};
+      _out.write( zeros.data(), static_cast< std::streamsize >( _to - _from ) );
+    }
+  }
+
+  /**
+   * Write a tree in the memory-mappable format described by \ref tree_file_header.
+   *
+   * The nodes and leafs are written as raw bytes, so the file can only be read on hosts with the same byte order
+   * and the same layout of the node and leaf types.
+   *
+   * \param _tree   the tree to write
+   * \param _path   the file to write
+   */
+  template< typename T, typename KDop, typename NodeData >
+  void write_tree_file( const bvh_tree< T, KDop, NodeData > &_tree, const std::string &_path )
+  {
+    using node_type = typename bvh_tree< T, KDop, NodeData >::node_type;
+    static_assert( std::is_trivially_copyable< node_type >::value, "tree nodes must be trivially copyable" );
+    static_assert( std::is_trivially_copyable< T >::value, "tree leafs must be trivially copyable" );
+    static_assert( alignof( node_type ) <= tree_file_alignment && alignof( T ) <= tree_file_alignment,
+                   "tree file alignment is too small" );
+
+    const auto &nodes = _tree.nodes();
+    const auto &leafs = _tree.leafs();
+
+    tree_file_header header;
+    header.magic = tree_file_magic;
+    header.version = tree_file_version;
+    header.byte_order = tree_file_byte_order;
+    header.node_size = sizeof( node_type );
+    header.leaf_size = sizeof( T );
+    header.num_nodes = nodes.size();
+    header.num_leafs = leafs.size();
+    header.nodes_offset = detail::tree_file_align( sizeof( tree_file_header ) );
+    header.leafs_offset = detail::tree_file_align( header.nodes_offset + header.num_nodes * header.node_size );
+
+    std::ofstream out( _path, std::ios::binary | std::ios::trunc );
+    if ( !out )
+      throw tree_file_exception( _path, "could not open the file for writing" );
+
+    out.write( reinterpret_cast< const char * >( &header ), sizeof( header ) );
+    detail::tree_file_pad( out, sizeof( header ), header.nodes_offset );
+    out.write( reinterpret_cast< const char * >( nodes.data() ),
+               static_cast< std::streamsize >( header.num_nodes * header.node_size ) );
+    detail::tree_file_pad( out, header.nodes_offset + header.num_nodes * header.node_size, header.leafs_offset );
+    out.write( reinterpret_cast< const char * >( leafs.data() ),
+               static_cast< std::streamsize >( header.num_leafs * header.leaf_size ) );
+
+    if ( !out )
+      throw tree_file_exception( _path, "could not write the file" );
+  }
+
+  /**
+   * A read-only tree backed by a file written with \ref write_tree_file and mapped into memory.
+   *
+   * Opening the file does not deserialize anything, pages are read on demand as the tree is traversed. The
+   * tree can be used with the query functions in `collision_query.hpp` like a \ref bvh_tree.
+   *
+   * \tparam T          the leaf type of the tree that was written
+   * \tparam KDop       the \f$k\f$-DOP type of the tree that was written
+   * \tparam NodeData   the node data type of the tree that was written
+   */
+  template< typename T, typename KDop, typename NodeData >
+  class mapped_tree
+  {
+  public:
+
+    using node_type = bvh_node< T, KDop, NodeData >;
+    using size_type = std::size_t;
+    using index_type = size_type;
+    using kdop_type = typename node_type::kdop_type;
+    using collision_query_result_type = collision_query_result< index_type >;
+    using value_type = T;
+
+    /**
+     * Map a tree file.
+     *
+     * The header and the offsets stored in the nodes are checked, so traversing a corrupt file can't read outside
+     * of the mapping. This reads every node once, the leafs are only read on demand.
+     *
+     * \param _path   the file to map
+     * \throws tree_file_exception if the file can't be mapped or was not written for this tree type
+     */
+    explicit mapped_tree( const std::string &_path )
+    {
+      const int fd = ::open( _path.c_str(), O_RDONLY );
+      if ( fd < 0 )
+        throw tree_file_exception( _path, std::strerror( errno ) );
+
+      struct stat st;
+      if ( ::fstat( fd, &st ) != 0 )
+      {
+        ::close( fd );
+        throw tree_file_exception( _path, std::strerror( errno ) );
+      }
+
+      m_length = static_cast< std::size_t >( st.st_size );
+      if ( m_length < sizeof( tree_file_header ) )
+      {
+        ::close( fd );
+        throw tree_file_exception( _path, "file is too small for the header" );
+      }
+
+      void *addr = ::mmap( nullptr, m_length, PROT_READ, MAP_SHARED, fd, 0 );
+      ::close( fd );
+      if ( addr == MAP_FAILED )
+        throw tree_file_exception( _path, std::strerror( errno ) );
+      m_addr = addr;
+
+      const char *error = validate();
+      if ( error )
+      {
+        unmap();
+        throw tree_file_exception( _path, error );
+      }
+
+      const auto &h = header();
+      const auto *base = static_cast< const unsigned char * >( m_addr );
+      m_nodes = reinterpret_cast< const node_type * >( base + h.nodes_offset );
+      m_num_nodes = h.num_nodes;
+      m_leafs = reinterpret_cast< const T * >( base + h.leafs_offset );
+      m_num_leafs = h.num_leafs;
+
+      error = validate_nodes();
+      if ( error )
+      {
+        unmap();
+        throw tree_file_exception( _path, error );
+      }
+    }
+
+    mapped_tree( const mapped_tree & ) = delete;
+    mapped_tree &operator=( const mapped_tree & ) = delete;
+
+    mapped_tree( mapped_tree &&_other ) noexcept
+    {
+      swap( _other );
+    }
+
+    mapped_tree &operator=( mapped_tree &&_other ) noexcept
+    {
+      mapped_tree tmp( std::move( _other ) );
+      swap( tmp );
+      return *this;
+    }
+
+    ~mapped_tree()
+    {
+      unmap();
+    }
+
+    /// \brief The header of the mapped file
+    const tree_file_header &header() const noexcept { return *static_cast< const tree_file_header * >( m_addr ); }
+
+    /// \brief The root of the tree or `nullptr` if the tree is empty
+    const node_type *root() const noexcept { return ( m_num_nodes == 0 ) ? nullptr : m_nodes; }
+
+    /// \brief The number of entities in the tree
+    size_type count() const noexcept { return m_num_leafs; }
+
+    /// \brief Whether the tree is empty
+    bool empty() const noexcept { return m_num_nodes == 0; }
+
+    /// \brief The bounds of the tree, or an empty \f$k\f$-DOP if the tree is empty
+    kdop_type bounds() const { return empty() ? kdop_type() : m_nodes[0].kdop(); }
+
+    /// \brief The entities of the tree, in the order the leaf nodes reference them
+    span< const T > leafs() const noexcept { return span< const T >( m_leafs, m_num_leafs ); }
+
+    /// \brief The nodes of the tree in pre-order traversal order
+    span< const node_type > nodes() const noexcept { return span< const node_type >( m_nodes, m_num_nodes ); }
+
+  private:
+
+    /// \return the reason the file does not match this tree type, or `nullptr`
+    const char *validate() const noexcept
+    {
+      const auto &h = header();
+      if ( h.magic != tree_file_magic )
+        return "not a tree file";
+      if ( h.version != tree_file_version )
+        return "unsupported version";
+      if ( h.byte_order != tree_file_byte_order )
+        return "written with a different byte order";
+      if ( h.node_size != sizeof( node_type ) || h.leaf_size != sizeof( T ) )
+        return "written for a different tree type";
+      if ( h.nodes_offset % tree_file_alignment != 0 || h.leafs_offset % tree_file_alignment != 0 )
+        return "misaligned arrays";
+      // Written as divisions so that a hostile header can't overflow the sizes
+      if ( h.nodes_offset > m_length || h.num_nodes > ( m_length - h.nodes_offset ) / h.node_size )
+        return "truncated";
+      if ( h.leafs_offset > m_length || h.num_leafs > ( m_length - h.leafs_offset ) / h.leaf_size )
+        return "truncated";
+      return nullptr;
+    }
+
+    /// \return the reason the nodes don't form a tree over the leafs, or `nullptr`
+    const char *validate_nodes() const noexcept
+    {
+      // Nodes are in pre-order: children come after their parent and point back to it
+      const auto n = static_cast< std::ptrdiff_t >( m_num_nodes );
+      for ( std::ptrdiff_t i = 0; i < n; ++i )
+      {
+        const auto &node = m_nodes[i];
+        const auto parent = node.get_parent_offset();
+        if ( ( i == 0 ) != ( parent == 0 ) || parent > 0 || i + parent < 0 )
+          return "corrupt parent offset";
+        if ( node.has_left() != node.has_right() )
+          return "corrupt child offsets";
+        for ( int c = 0; c < 2 && !node.is_leaf(); ++c )
+        {
+          const auto child = node.get_child_offset( c );
+          if ( child <= 0 || child >= n - i || m_nodes[i + child].get_parent_offset() != -child )
+            return "corrupt child offsets";
+        }
+        const auto &entities = node.get_patch();
+        if ( entities[0] > entities[1] || entities[1] > m_num_leafs )
+          return "corrupt entity offsets";
+      }
+      return nullptr;
+    }
+
+    void unmap() noexcept
+    {
+      if ( m_addr )
+        ::munmap( m_addr, m_length );
+      m_addr = nullptr;
+      m_length = 0;
+    }
+
+    void swap( mapped_tree &_other ) noexcept
+    {
+      std::swap( m_addr, _other.m_addr );
+      std::swap( m_length, _other.m_length );
+      std::swap( m_nodes, _other.m_nodes );
+      std::swap( m_num_nodes, _other.m_num_nodes );
+      std::swap( m_leafs, _other.m_leafs );
+      std::swap( m_num_leafs, _other.m_num_leafs );
+    }
+
+    void *m_addr = nullptr;
+    std::size_t m_length = 0;
+    const node_type *m_nodes = nullptr;
+    std::size_t m_num_nodes = 0;
+    const T *m_leafs = nullptr;
+    std::size_t m_num_leafs = 0;
+  };
+
+  using mapped_snapshot_tree = mapped_tree< entity_snapshot, bphase_kdop, void >;
+}
+
+#endif  // INC_BVH_SERIALIZATION_TREE_FILE_HPP
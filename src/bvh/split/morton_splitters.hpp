@@ -0,0 +1,150 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef INC_BVH_SPLIT_MORTON_SPLITTERS_HPP
+#define INC_BVH_SPLIT_MORTON_SPLITTERS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <cstddef>
+#include <vector>
+#include "../util/span.hpp"
+
+namespace bvh
+{
+  /**
+   * Pick evenly spaced samples from a sorted sequence of keys, for a sample sort.
+   *
+   * \param _sorted       the sorted keys
+   * \param _num_samples  the number of samples to take
+   * \return              the samples in sorted order, empty if there are no keys
+   */
+  template< typename Key >
+  std::vector< Key >
+  regular_samples( span< const Key > _sorted, std::size_t _num_samples )
+  {
+    std::vector< Key > ret;
+    const std::size_t n = _sorted.size();
+    if ( n == 0 )
+      return ret;
+
+    ret.reserve( _num_samples );
+    for ( std::size_t i = 0; i < _num_samples; ++i )
+      ret.push_back( _sorted[( ( i + 1 ) * n ) / ( _num_samples + 1 )] );
+
+    return ret;
+  }
+
+  /**
+   * Choose the splitters that divide the key space into `_num_ranges` ranges holding roughly the same
+   * number of samples. Range `r` holds the keys `k` with `splitters[r - 1] <= k < splitters[r]`.
+   *
+   * \param _samples      the gathered samples, in any order
+   * \param _num_ranges   the number of ranges
+   * \return              `_num_ranges - 1` sorted splitters, or none if there are no samples
+   */
+  template< typename Key >
+  std::vector< Key >
+  choose_splitters( std::vector< Key > _samples, std::size_t _num_ranges )
+  {
+    std::vector< Key > ret;
+    if ( _samples.empty() || _num_ranges < 2 )
+      return ret;
+
+    std::sort( _samples.begin(), _samples.end() );
+
+    const std::size_t n = _samples.size();
+    ret.reserve( _num_ranges - 1 );
+    for ( std::size_t r = 1; r < _num_ranges; ++r )
+      ret.push_back( _samples[std::min( ( r * n ) / _num_ranges, n - 1 )] );
+
+    return ret;
+  }
+
+  /**
+   * Compute split offsets of a sorted sequence of keys that prefer the boundaries between the ranges
+   * defined by `_splitters`, so that splits of different sequences cut the key space at the same places.
+   *
+   * Each offset is placed on the range boundary closest to the evenly spaced offset, unless that boundary is
+   * more than half a split away, in which case the evenly spaced offset is used.
+   *
+   * \param _sorted       the sorted keys
+   * \param _splitters    the sorted splitters, see \ref choose_splitters
+   * \param _num_splits   the number of offsets to compute
+   * \return              the split offsets, non-decreasing, with the meaning of `element_permutations::splits`
+   */
+  template< typename Key >
+  std::vector< std::size_t >
+  coherent_splits( span< const Key > _sorted, span< const Key > _splitters, std::size_t _num_splits )
+  {
+    const std::size_t n = _sorted.size();
+
+    // Offsets where the sequence enters a different range
+    std::vector< std::size_t > boundaries;
+    auto range_of = [&_splitters]( const Key &_k ) {
+      return std::upper_bound( _splitters.begin(), _splitters.end(), _k ) - _splitters.begin();
+    };
+    for ( std::size_t j = 1; j < n; ++j )
+      if ( range_of( _sorted[j - 1] ) != range_of( _sorted[j] ) )
+        boundaries.push_back( j );
+
+    std::vector< std::size_t > ret;
+    ret.reserve( _num_splits );
+    const double width = static_cast< double >( n ) / static_cast< double >( _num_splits + 1 );
+    std::size_t prev = 0;
+    for ( std::size_t k = 1; k <= _num_splits; ++k )
+    {
+      const auto target = static_cast< std::size_t >( static_cast< double >( k ) * width );
+      std::size_t cut = std::max( target, prev );
+
+      // Closest boundary at or after the previous cut
+      auto it = std::lower_bound( boundaries.begin(), boundaries.end(), cut );
+      std::size_t best = n + 1;
+      if ( it != boundaries.end() )
+        best = *it;
+      if ( it != boundaries.begin() && *std::prev( it ) >= prev
+           && ( best == n + 1 || cut - *std::prev( it ) < best - cut ) )
+        best = *std::prev( it );
+
+      if ( best <= n && std::abs( static_cast< double >( best ) - static_cast< double >( cut ) ) <= 0.5 * width )
+        cut = best;
+
+      ret.push_back( cut );
+      prev = cut;
+    }
+
+    return ret;
+  }
+}
+
+#endif  // INC_BVH_SPLIT_MORTON_SPLITTERS_HPP
@@ -0,0 +1,176 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef INC_BVH_SPLIT_OVERDECOMPOSITION_HPP
+#define INC_BVH_SPLIT_OVERDECOMPOSITION_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+
+namespace bvh
+{
+  /// Time spent by one rank in each phase of the collision detection of an object, in seconds
+  struct phase_times
+  {
+    double broadphase = 0.0;
+    double ghosting = 0.0;
+    double narrowphase = 0.0;
+
+    phase_times &operator+=( const phase_times &_other ) noexcept
+    {
+      broadphase += _other.broadphase;
+      ghosting += _other.ghosting;
+      narrowphase += _other.narrowphase;
+      return *this;
+    }
+
+    template< typename Serializer >
+    void serialize( Serializer &_s )
+    {
+      _s | broadphase | ghosting | narrowphase;
+    }
+  };
+
+  /// The phase times of every rank over a number of steps
+  struct phase_costs
+  {
+    phase_times total; ///< Summed over the ranks
+    phase_times max; ///< Largest of any rank
+    std::size_t num_ranks = 0;
+
+    template< typename Serializer >
+    void serialize( Serializer &_s )
+    {
+      _s | total | max | num_ranks;
+    }
+  };
+
+  /// \brief Add the time until destruction to a phase time
+  class phase_timer
+  {
+  public:
+
+    /// \param[in] _enabled  whether to measure at all, so disabled timers don't read the clock
+    /// \param[in] _target   the phase time to add to
+    phase_timer( bool _enabled, double &_target ) noexcept
+      : m_target( _enabled ? &_target : nullptr )
+    {
+      if ( m_target )
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    phase_timer( const phase_timer & ) = delete;
+    phase_timer &operator=( const phase_timer & ) = delete;
+
+    ~phase_timer()
+    {
+      if ( m_target )
+        *m_target += std::chrono::duration< double >( std::chrono::steady_clock::now() - m_start ).count();
+    }
+
+  private:
+
+    double *m_target;
+    std::chrono::steady_clock::time_point m_start;
+  };
+
+  /**
+   * Predict the cost of a step, i.e. the time of the slowest rank, if the overdecomposition factor was changed.
+   *
+   * The broadphase and ghosting are per-patch overheads and are assumed to grow linearly with the number of patches.
+   * The mean narrowphase work doesn't depend on the patches, but its imbalance between the ranks is assumed to
+   * shrink with the square root of the number of patches, as it does for randomly distributed work.
+   *
+   * \param _costs         the measured phase times at `_od`
+   * \param _od            the current overdecomposition factor
+   * \param _candidate_od  the overdecomposition factor to predict the cost for
+   * \return               the predicted cost
+   */
+  inline double
+  predicted_step_cost( const phase_costs &_costs, std::size_t _od, std::size_t _candidate_od )
+  {
+    const double ratio = static_cast< double >( _candidate_od ) / static_cast< double >( _od );
+    const double overhead = ( _costs.max.broadphase + _costs.max.ghosting ) * ratio;
+
+    const double mean_narrow = _costs.total.narrowphase / static_cast< double >( std::max< std::size_t >( _costs.num_ranks, 1 ) );
+    const double imbalance = std::max( _costs.max.narrowphase - mean_narrow, 0.0 );
+
+    return overhead + mean_narrow + imbalance / std::sqrt( ratio );
+  }
+
+  /**
+   * Choose the overdecomposition factor for the next steps. The neighboring powers of two within the bounds are
+   * considered, and the factor only changes if the predicted cost of a step drops by more than `_min_gain`, since
+   * changing it re-splits the elements and rebuilds the collections.
+   *
+   * \param _costs     the measured phase times at `_od`
+   * \param _od        the current overdecomposition factor
+   * \param _min_od    the smallest allowed factor, a power of two
+   * \param _max_od    the largest allowed factor, a power of two
+   * \param _min_gain  the relative reduction of the step cost required to change the factor
+   * \return           the overdecomposition factor for the next steps, `_od` if it should stay
+   */
+  inline std::size_t
+  choose_overdecomposition( const phase_costs &_costs, std::size_t _od, std::size_t _min_od, std::size_t _max_od,
+                            double _min_gain )
+  {
+    // Move into the bounds no matter the cost
+    if ( _od < _min_od )
+      return _min_od;
+    if ( _od > _max_od )
+      return _max_od;
+
+    const double current = predicted_step_cost( _costs, _od, _od );
+    if ( current <= 0.0 )
+      return _od;
+
+    std::size_t best = _od;
+    double best_cost = current;
+    for ( auto candidate : { _od / 2, _od * 2 } )
+    {
+      if ( candidate < _min_od || candidate > _max_od || candidate == 0 )
+        continue;
+      const double cost = predicted_step_cost( _costs, _od, candidate );
+      if ( cost < best_cost )
+      {
+        best = candidate;
+        best_cost = cost;
+      }
+    }
+
+    return ( current - best_cost > _min_gain * current ) ? best : _od;
+  }
+}
+
+#endif  // INC_BVH_SPLIT_OVERDECOMPOSITION_HPP
@@ -0,0 +1,108 @@
+/*
+ * distBVH 1.0
+ *
+ * Copyright 2023 National Technology & Engineering Solutions of Sandia, LLC
+ * (NTESS). Under the terms of Contract DE-NA0003525 with NTESS, the U.S.
+ * Government retains certain rights in this software.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef INC_BVH_SPLIT_REBALANCE_HPP
+#define INC_BVH_SPLIT_REBALANCE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "../util/span.hpp"
+
+namespace bvh
+{
+  /**
+   * Compute split offsets that divide a sequence of weighted elements into `_num_splits + 1`
+   * contiguous ranges of roughly equal total weight. The offsets have the same meaning as
+   * `element_permutations::splits`, i.e. split `i` ends at offset `i` (exclusive).
+   *
+   * Heavy elements are not divided, so a single element heavier than the target weight leaves
+   * the following ranges empty.
+   *
+   * \param _weights      the weight of each element, in split order
+   * \param _num_splits   the number of offsets to compute
+   * \return              the split offsets, non-decreasing
+   */
+  inline std::vector< std::size_t >
+  weighted_splits( span< const double > _weights, std::size_t _num_splits )
+  {
+    std::vector< std::size_t > ret;
+    ret.reserve( _num_splits );
+
+    double total = 0.0;
+    for ( auto &&w : _weights )
+      total += w;
+
+    const double target = total / static_cast< double >( _num_splits + 1 );
+
+    double prefix = 0.0;
+    std::size_t j = 0;
+    for ( std::size_t i = 1; i <= _num_splits; ++i )
+    {
+      const double cut = target * static_cast< double >( i );
+      // Take elements while the cut is closer to the end of the element than to its start
+      while ( j < _weights.size() && prefix + 0.5 * _weights[j] < cut )
+        prefix += _weights[j++];
+      ret.push_back( j );
+    }
+
+    return ret;
+  }
+
+  /**
+   * Find the largest load of a set of ranges relative to the mean load.
+   *
+   * \param _loads  the load of each range
+   * \return        the ratio of the maximum load to the mean load, or 0 if there is no load at all
+   */
+  inline double
+  max_load_imbalance( span< const double > _loads )
+  {
+    if ( _loads.size() == 0 )
+      return 0.0;
+
+    double total = 0.0;
+    double max_load = 0.0;
+    for ( auto &&l : _loads )
+    {
+      total += l;
+      max_load = std::max( max_load, l );
+    }
+
+    if ( total <= 0.0 )
+      return 0.0;
+
+    return max_load * static_cast< double >( _loads.size() ) / total;
+  }
+}
+
+#endif  // INC_BVH_SPLIT_REBALANCE_HPP
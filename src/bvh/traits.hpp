@@ -33,6 +33,9 @@
 #ifndef INC_BVH_TRAITS_HPP
 #define INC_BVH_TRAITS_HPP
 
+#include <type_traits>
+#include <utility>
+
 namespace bvh
 {
   template< typename... >
@@ -109,7 +112,42 @@ namespace bvh
     {
       return get_global_id_impl( _element, overload_priority< 1 >{} );
     }
+
+    template< typename Element >
+    constexpr auto get_body_id_impl( const Element &_element, overload_priority< 1 > )
+      -> decltype( get_entity_body_id( _element ) )
+    {
+      return get_entity_body_id( _element );
+    }
+
+    template< typename Element >
+    constexpr auto get_body_id_impl( const Element &_element, overload_priority< 0 >  )
+      -> decltype( _element.body_id() )
+    {
+      return _element.body_id();
+    }
+
+    template< typename Element >
+    constexpr auto get_body_id( const Element &_element )
+      -> decltype( get_body_id_impl( _element, overload_priority< 1 >{} ) )
+    {
+      return get_body_id_impl( _element, overload_priority< 1 >{} );
+    }
+
+    template< typename Element, typename = void >
+    struct has_body_id : std::false_type
+    {};
+
+    template< typename Element >
+    struct has_body_id< Element, void_t< decltype( get_body_id( std::declval< const Element & >() ) ) > >
+      : std::true_type
+    {};
   }
+
+  /// Whether elements of type `Element` belong to one of the bodies of a multi-body collision object, i.e. they have
+  /// a `body_id()` member or a `get_entity_body_id( const Element & )` overload
+  template< typename Element >
+  inline constexpr bool has_body_id_v = detail::has_body_id< Element >::value;
   
   template< typename Element >
   struct element_traits
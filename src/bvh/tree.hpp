@@ -106,6 +106,19 @@ namespace bvh
       std::reverse( m_nodes.begin(), m_nodes.end() );
     }
 
+    /**
+     * Construct a tree from its leafs and its nodes in pre-order traversal order, e.g. when decoding a tree that was
+     * sent in another format. The node offsets are not checked.
+     *
+     * \param _leafs  the entities referenced by the leaf nodes
+     * \param _nodes  the nodes in pre-order traversal order
+     */
+    bvh_tree( dynarray< T > &&_leafs, dynarray< node_type > &&_nodes ) noexcept
+      : m_leafs( std::move( _leafs ) ),
+        m_nodes( std::move( _nodes ) )
+    {
+    }
+
     /**
      * Copy constructor. \f$O(n + m)\f$.
      *
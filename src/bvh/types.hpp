@@ -45,15 +45,35 @@ namespace bvh
 
 #ifndef BVH_BROADPHASE_6_DOP
   using bphase_kdop = dop_26< float_type >;
+  using compact_bphase_kdop = dop_26< float >;  ///< Storage of \ref compact_entity_snapshot bounds
 #else
   using bphase_kdop = dop_6< float_type >;
+  using compact_bphase_kdop = dop_6< float >;  ///< Storage of \ref compact_entity_snapshot bounds
 #endif
 
   enum class split_algorithm
   {
     geom_axis,
     ml_geom_axis,
-    clustering
+    clustering,
+    global_morton  ///< Local morton split with cuts snapped to global key ranges; `set_entity_data` becomes collective
+  };
+
+  /// \brief Which object of a `collision_object::broadphase` call supplies the patches that are
+  /// queried against the tree of the other object
+  enum class broadphase_orientation
+  {
+    this_patches,   ///< Query the patches of `this` against the tree of the other object
+    other_patches,  ///< Query the patches of the other object against the tree of `this`
+    automatic       ///< Choose the cheaper orientation from the patch counts of both trees
+  };
+
+  /// \brief An element that moved to a different local patch, see `collision_object::patch_membership_changes`
+  struct patch_membership_change
+  {
+    std::size_t element;     ///< Index of the element in the data passed to `set_entity_data`
+    std::size_t from_patch;  ///< Local patch index of the element in the previous step
+    std::size_t to_patch;    ///< Local patch index of the element in this step
   };
 
 }
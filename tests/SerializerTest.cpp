@@ -32,6 +32,12 @@
  */
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
 #include <string>
 #include <bvh/math/vec.hpp>
 #include <bvh/kdop.hpp>
@@ -39,6 +45,11 @@
 #include <bvh/tree.hpp>
 #include <bvh/types.hpp>
 #include <bvh/serialization/bvh_serialize.hpp>
+#include <bvh/serialization/tree_file.hpp>
+#include <bvh/serialization/compact_tree.hpp>
+#include <bvh/capture.hpp>
+#include <bvh/exceptions/capture_file_exception.hpp>
+#include <bvh/collision_query.hpp>
 #include <bvh/tree_build.hpp>
 #include <bvh/collision_object/narrowphase.hpp>
 #include <bvh/collision_object/types.hpp>
@@ -95,6 +106,228 @@ TEST_CASE("patch serialization", "[serializer][patch]" )
   REQUIRE( pd.centroid() == p.centroid() );
 }
 
+TEST_CASE("tree file", "[serializer][tree]" )
+{
+  const std::string path = "tree_file_test." + std::to_string( ::vt::theContext()->getNode() ) + ".bin";
+
+  SECTION( "mapped tree matches the written tree" )
+  {
+    auto elements = buildElementGrid( 4, 4, 4 );
+    auto tree = bvh::build_snapshot_tree_top_down< Element >( elements );
+    bvh::write_tree_file( tree, path );
+
+    bvh::mapped_snapshot_tree mapped( path );
+    REQUIRE( mapped.count() == tree.count() );
+    REQUIRE( mapped.nodes().size() == tree.nodes().size() );
+    for ( std::size_t i = 0; i < tree.nodes().size(); ++i )
+      REQUIRE( mapped.nodes()[i] == tree.nodes()[i] );
+    for ( std::size_t i = 0; i < tree.leafs().size(); ++i )
+      REQUIRE( mapped.leafs()[i] == tree.leafs()[i] );
+
+    // Queries run in place on the mapped file
+    REQUIRE( bvh::self_collision_set( mapped ).pairs == bvh::self_collision_set( tree ).pairs );
+
+    // Moving the mapping keeps the tree valid
+    bvh::mapped_snapshot_tree moved( std::move( mapped ) );
+    REQUIRE( moved.root() != nullptr );
+    REQUIRE( moved.count() == tree.count() );
+  }
+
+  SECTION( "empty tree" )
+  {
+    bvh::snapshot_tree tree;
+    bvh::write_tree_file( tree, path );
+
+    bvh::mapped_snapshot_tree mapped( path );
+    REQUIRE( mapped.empty() );
+    REQUIRE( mapped.root() == nullptr );
+  }
+
+  SECTION( "invalid file" )
+  {
+    {
+      std::ofstream out( path, std::ios::binary | std::ios::trunc );
+      out << "not a tree file, but long enough to hold a tree file header..................";
+    }
+    REQUIRE_THROWS_AS( bvh::mapped_snapshot_tree( path ), bvh::tree_file_exception );
+  }
+
+  SECTION( "corrupt header and nodes" )
+  {
+    using node_type = bvh::mapped_snapshot_tree::node_type;
+    auto elements = buildElementGrid( 4, 4, 4 );
+    auto tree = bvh::build_snapshot_tree_top_down< Element >( elements );
+    bvh::write_tree_file( tree, path );
+
+    std::string bytes;
+    {
+      std::ifstream in( path, std::ios::binary );
+      bytes.assign( std::istreambuf_iterator< char >( in ), std::istreambuf_iterator< char >() );
+    }
+    bvh::tree_file_header header;
+    std::memcpy( &header, bytes.data(), sizeof( header ) );
+
+    auto write_modified = [&path, &bytes]( auto &&_modify ) {
+      auto modified = bytes;
+      _modify( modified );
+      std::ofstream out( path, std::ios::binary | std::ios::trunc );
+      out.write( modified.data(), static_cast< std::streamsize >( modified.size() ) );
+    };
+
+    // A node count whose byte size overflows to a small number
+    write_modified( [&header]( std::string &_bytes ) {
+      auto h = header;
+      h.num_nodes = std::numeric_limits< std::uint64_t >::max() / h.node_size + 1;
+      std::memcpy( _bytes.data(), &h, sizeof( h ) );
+    } );
+    REQUIRE_THROWS_AS( bvh::mapped_snapshot_tree( path ), bvh::tree_file_exception );
+
+    // A child outside of the node array
+    write_modified( [&header]( std::string &_bytes ) {
+      node_type root;
+      std::memcpy( &root, _bytes.data() + header.nodes_offset, sizeof( root ) );
+      root.set_child_offset( 1, static_cast< std::ptrdiff_t >( header.num_nodes ) );
+      std::memcpy( _bytes.data() + header.nodes_offset, &root, sizeof( root ) );
+    } );
+    REQUIRE_THROWS_AS( bvh::mapped_snapshot_tree( path ), bvh::tree_file_exception );
+
+    // A leaf range past the end of the leaf array
+    write_modified( [&header]( std::string &_bytes ) {
+      node_type last;
+      const auto offset = header.nodes_offset + ( header.num_nodes - 1 ) * sizeof( node_type );
+      std::memcpy( &last, _bytes.data() + offset, sizeof( last ) );
+      last.set_patch( 0, header.num_leafs + 1 );
+      std::memcpy( _bytes.data() + offset, &last, sizeof( last ) );
+    } );
+    REQUIRE_THROWS_AS( bvh::mapped_snapshot_tree( path ), bvh::tree_file_exception );
+  }
+
+  std::remove( path.c_str() );
+}
+
+TEST_CASE("compact tree", "[serializer][tree]" )
+{
+  auto contains = []( const bvh::bphase_kdop &_outer, const bvh::bphase_kdop &_inner ) {
+    for ( int a = 0; a < bvh::bphase_kdop::num_axis; ++a )
+      if ( _outer.extents[a].min > _inner.extents[a].min || _outer.extents[a].max < _inner.extents[a].max )
+        return false;
+    return true;
+  };
+
+  SECTION( "decoded tree is conservative" )
+  {
+    auto elements = buildElementGrid( 8, 8, 8 );
+    auto tree = bvh::build_snapshot_tree_top_down< Element >( elements );
+
+    bvh::compact_snapshot_tree compact( tree );
+    auto serialized = checkpoint::serialize( compact );
+    REQUIRE( serialized->getSize() < checkpoint::serialize( tree )->getSize() / 3 );
+
+    auto decoded = checkpoint::deserialize< bvh::compact_snapshot_tree >( serialized->getBuffer() )->decode();
+    REQUIRE( decoded.count() == tree.count() );
+    REQUIRE( decoded.nodes().size() == tree.nodes().size() );
+    for ( std::size_t i = 0; i < tree.nodes().size(); ++i )
+    {
+      const auto &n = tree.nodes()[i];
+      const auto &d = decoded.nodes()[i];
+      REQUIRE( d.get_child_offset( 0 ) == n.get_child_offset( 0 ) );
+      REQUIRE( d.get_child_offset( 1 ) == n.get_child_offset( 1 ) );
+      REQUIRE( d.get_patch() == n.get_patch() );
+      REQUIRE( contains( d.kdop(), n.kdop() ) );
+    }
+    for ( std::size_t i = 0; i < tree.leafs().size(); ++i )
+    {
+      REQUIRE( decoded.leafs()[i].global_id() == tree.leafs()[i].global_id() );
+      REQUIRE( decoded.leafs()[i].local_index() == tree.leafs()[i].local_index() );
+      REQUIRE( contains( decoded.leafs()[i].kdop(), tree.leafs()[i].kdop() ) );
+    }
+
+    // Only bounds grow, so every overlap of the original tree is still found
+    auto pairs = bvh::self_collision_set( tree ).pairs;
+    auto decoded_pairs = bvh::self_collision_set( decoded ).pairs;
+    std::sort( decoded_pairs.begin(), decoded_pairs.end() );
+    for ( auto &&p : pairs )
+      REQUIRE( std::binary_search( decoded_pairs.begin(), decoded_pairs.end(), p ) );
+  }
+
+  SECTION( "empty tree" )
+  {
+    bvh::compact_snapshot_tree compact{ bvh::snapshot_tree{} };
+    auto serialized = checkpoint::serialize( compact );
+    auto decoded = checkpoint::deserialize< bvh::compact_snapshot_tree >( serialized->getBuffer() )->decode();
+    REQUIRE( decoded.empty() );
+  }
+}
+
+TEST_CASE("capture file", "[serializer][capture]" )
+{
+  const auto rank = static_cast< std::uint32_t >( ::vt::theContext()->getNode() );
+  const auto path = bvh::capture_file_path( "capture_file_test", rank );
+
+  auto elements = buildElementGrid( 2, 2, 2 );
+  std::vector< bvh::entity_snapshot > snapshots;
+  for ( std::size_t i = 0; i < elements.size(); ++i )
+    snapshots.push_back( bvh::make_snapshot( elements[i], i ) );
+
+  {
+    bvh::capture_writer writer( path, rank, 4, 8 );
+    writer.begin_iteration();
+    writer.set_entity_data( 1, bvh::split_algorithm::clustering, sizeof( Element ), snapshots );
+    writer.init_broadphase( 1 );
+    writer.broadphase( 1, 0, bvh::broadphase_orientation::automatic );
+    writer.end_iteration();
+  }
+
+  bvh::capture_reader reader( path );
+  REQUIRE( reader.header().rank == rank );
+  REQUIRE( reader.header().num_ranks == 4 );
+  REQUIRE( reader.header().overdecomposition == 8 );
+
+  bvh::capture_event ev;
+  REQUIRE( reader.next( ev ) );
+  REQUIRE( ev.kind == bvh::capture_record::begin_iteration );
+
+  REQUIRE( reader.next( ev ) );
+  REQUIRE( ev.kind == bvh::capture_record::set_entity_data );
+  REQUIRE( ev.object == 1 );
+  REQUIRE( ev.algorithm == bvh::split_algorithm::clustering );
+  REQUIRE( ev.element_size == sizeof( Element ) );
+  REQUIRE( ev.entities.size() == snapshots.size() );
+  for ( std::size_t i = 0; i < snapshots.size(); ++i )
+    REQUIRE( ev.entities[i].snapshot == snapshots[i] );
+
+  REQUIRE( reader.next( ev ) );
+  REQUIRE( ev.kind == bvh::capture_record::init_broadphase );
+  REQUIRE( ev.object == 1 );
+
+  REQUIRE( reader.next( ev ) );
+  REQUIRE( ev.kind == bvh::capture_record::broadphase );
+  REQUIRE( ev.object == 1 );
+  REQUIRE( ev.other == 0 );
+  REQUIRE( ev.orientation == bvh::broadphase_orientation::automatic );
+
+  REQUIRE( reader.next( ev ) );
+  REQUIRE( ev.kind == bvh::capture_record::end_iteration );
+  REQUIRE( !reader.next( ev ) );
+
+  // A corrupt element count is reported instead of being allocated
+  {
+    const std::uint64_t bad_count = std::uint64_t{ 1 } << 60;
+    const auto count_offset = sizeof( bvh::capture_header ) + 2 * sizeof( bvh::capture_record ) + sizeof( std::uint64_t )
+                              + sizeof( std::uint32_t ) + sizeof( std::uint64_t );
+    std::fstream f( path, std::ios::binary | std::ios::in | std::ios::out );
+    f.seekp( static_cast< std::streamoff >( count_offset ) );
+    f.write( reinterpret_cast< const char * >( &bad_count ), sizeof( bad_count ) );
+  }
+  bvh::capture_reader corrupt_reader( path );
+  REQUIRE( corrupt_reader.next( ev ) );
+  REQUIRE_THROWS_AS( corrupt_reader.next( ev ), bvh::capture_file_exception );
+
+  std::remove( path.c_str() );
+
+  REQUIRE_THROWS_AS( bvh::capture_reader( path ), bvh::capture_file_exception );
+}
+
 namespace
 {
   void check_ghost_msg( bvh::collision_object_impl::ghost_msg *_msg )
@@ -33,12 +33,16 @@
 #include <catch2/catch.hpp>
 
 #include <array>
+#include <cstdint>
 #include <iterator>
 #include <vector>
 
 #include <bvh/split/axis.hpp>
 #include <bvh/split/split.hpp>
 #include <bvh/split/mean.hpp>
+#include <bvh/split/morton_splitters.hpp>
+#include <bvh/split/overdecomposition.hpp>
+#include <bvh/split/rebalance.hpp>
 #include <bvh/kdop.hpp>
 #include <bvh/range.hpp>
 #include <bvh/snapshot.hpp>
@@ -437,3 +441,123 @@ TEST_CASE("new recursive mean splitting 2D elements", "[split]")
     //
   }
 }
+
+TEST_CASE( "weighted splits", "[split]" )
+{
+  SECTION( "uniform weights" )
+  {
+    std::vector< double > weights( 8, 1.0 );
+    auto splits = bvh::weighted_splits( weights, 3 );
+    REQUIRE( splits == std::vector< std::size_t >{ 2, 4, 6 } );
+  }
+
+  SECTION( "hot elements are separated" )
+  {
+    std::vector< double > weights{ 1.0, 1.0, 1.0, 1.0, 9.0, 9.0, 1.0, 1.0 };
+    auto splits = bvh::weighted_splits( weights, 3 );
+    REQUIRE( splits == std::vector< std::size_t >{ 4, 5, 6 } );
+  }
+
+  SECTION( "no splits" )
+  {
+    std::vector< double > weights( 4, 1.0 );
+    REQUIRE( bvh::weighted_splits( weights, 0 ).empty() );
+  }
+
+  SECTION( "load imbalance" )
+  {
+    std::vector< double > loads{ 1.0, 1.0, 1.0, 5.0 };
+    REQUIRE( bvh::max_load_imbalance( loads ) == Approx( 2.5 ) );
+
+    std::vector< double > empty_loads( 4, 0.0 );
+    REQUIRE( bvh::max_load_imbalance( empty_loads ) == 0.0 );
+  }
+}
+
+TEST_CASE( "adaptive overdecomposition", "[split]" )
+{
+  // Per-patch overhead dominates and the narrowphase is balanced over 4 ranks
+  bvh::phase_costs overhead;
+  overhead.num_ranks = 4;
+  overhead.max = bvh::phase_times{ 1.0, 1.0, 1.0 };
+  overhead.total = bvh::phase_times{ 4.0, 4.0, 4.0 };
+
+  // The narrowphase is imbalanced, one rank does most of it
+  bvh::phase_costs imbalanced;
+  imbalanced.num_ranks = 4;
+  imbalanced.max = bvh::phase_times{ 0.1, 0.1, 4.0 };
+  imbalanced.total = bvh::phase_times{ 0.4, 0.4, 4.0 };
+
+  SECTION( "cost model" )
+  {
+    REQUIRE( bvh::predicted_step_cost( overhead, 8, 8 ) == Approx( 3.0 ) );
+    REQUIRE( bvh::predicted_step_cost( overhead, 8, 4 ) == Approx( 2.0 ) );
+    REQUIRE( bvh::predicted_step_cost( imbalanced, 8, 8 ) == Approx( 4.2 ) );
+    REQUIRE( bvh::predicted_step_cost( imbalanced, 8, 32 ) == Approx( 0.8 + 1.0 + 1.5 ) );
+  }
+
+  SECTION( "fewer patches when the overhead dominates" )
+  {
+    REQUIRE( bvh::choose_overdecomposition( overhead, 8, 1, 64, 0.1 ) == 4 );
+  }
+
+  SECTION( "more patches when the narrowphase is imbalanced" )
+  {
+    REQUIRE( bvh::choose_overdecomposition( imbalanced, 8, 1, 64, 0.1 ) == 16 );
+  }
+
+  SECTION( "small gains keep the factor" )
+  {
+    REQUIRE( bvh::choose_overdecomposition( overhead, 8, 1, 64, 0.5 ) == 8 );
+  }
+
+  SECTION( "bounds" )
+  {
+    REQUIRE( bvh::choose_overdecomposition( overhead, 8, 8, 64, 0.1 ) == 8 );
+    REQUIRE( bvh::choose_overdecomposition( imbalanced, 8, 1, 8, 0.1 ) == 8 );
+    REQUIRE( bvh::choose_overdecomposition( overhead, 8, 16, 64, 0.1 ) == 16 );
+    REQUIRE( bvh::choose_overdecomposition( imbalanced, 8, 1, 4, 0.1 ) == 4 );
+  }
+
+  SECTION( "nothing timed" )
+  {
+    REQUIRE( bvh::choose_overdecomposition( bvh::phase_costs{}, 8, 1, 64, 0.1 ) == 8 );
+  }
+}
+
+TEST_CASE( "morton splitters", "[split]" )
+{
+  using key_type = std::uint32_t;
+
+  SECTION( "regular samples" )
+  {
+    std::vector< key_type > keys{ 1, 2, 3, 4, 10, 11, 12, 13, 20, 21, 22, 23 };
+    auto samples = bvh::regular_samples< key_type >( keys, 3 );
+    REQUIRE( samples == std::vector< key_type >{ 4, 12, 21 } );
+    REQUIRE( bvh::regular_samples< key_type >( std::vector< key_type >{}, 3 ).empty() );
+  }
+
+  SECTION( "splitters" )
+  {
+    std::vector< key_type > samples{ 30, 5, 25, 10, 20, 15 };
+    auto splitters = bvh::choose_splitters( samples, 3 );
+    REQUIRE( splitters == std::vector< key_type >{ 15, 25 } );
+    REQUIRE( bvh::choose_splitters( samples, 1 ).empty() );
+  }
+
+  SECTION( "splits snap to range boundaries" )
+  {
+    std::vector< key_type > keys{ 1, 2, 3, 4, 5, 10, 11, 12, 13, 20, 21, 22 };
+    std::vector< key_type > splitters{ 10, 20 };
+    auto splits = bvh::coherent_splits< key_type >( keys, splitters, 2 );
+    REQUIRE( splits == std::vector< std::size_t >{ 5, 9 } );
+  }
+
+  SECTION( "distant boundaries are ignored" )
+  {
+    std::vector< key_type > keys{ 1, 2, 3, 5, 6, 7, 8, 9, 10, 11, 12, 13 };
+    std::vector< key_type > splitters{ 10, 20 };
+    auto splits = bvh::coherent_splits< key_type >( keys, splitters, 2 );
+    REQUIRE( splits == std::vector< std::size_t >{ 4, 8 } );
+  }
+}
@@ -35,8 +35,17 @@
 #include <bvh/vt/helpers.hpp>
 #include <bvh/collision_object.hpp>
 #include <bvh/collision_world.hpp>
+#include <bvh/capture.hpp>
+#include <bvh/collision_object/types.hpp>
+#include <bvh/collision_object/impl.hpp>
+#include <bvh/collision_world/narrowphase_scheduler.hpp>
 #include <bvh/util/epoch.hpp>
+#include <bvh/exceptions/state_file_exception.hpp>
 #include <bvh/vt/print.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
 #include <numeric>
 #include <type_traits>
 #include <vt/collective/collective_alg.h>
@@ -128,7 +137,8 @@ TEST_CASE( "collision_object init", "[vt]")
   auto update_elements = build_element_grid( 2 * od_factor, 3 * od_factor, 2 * od_factor, rank * 12 * od_factor, 10.0 );
 
   auto split_method
-    = GENERATE( bvh::split_algorithm::geom_axis, bvh::split_algorithm::ml_geom_axis, bvh::split_algorithm::clustering );
+    = GENERATE( bvh::split_algorithm::geom_axis, bvh::split_algorithm::ml_geom_axis, bvh::split_algorithm::clustering,
+                bvh::split_algorithm::global_morton );
 
   bvh::vt::debug("{}: od_factor: {} split method: {}\n", ::vt::theContext()->getNode(), od_factor, static_cast< int >( split_method ) );
 
@@ -247,10 +257,195 @@ TEST_CASE( "collision_object init", "[vt]")
   }
 }
 
-TEST_CASE( "collision_object broadphase", "[vt]")
+TEST_CASE( "collision_object patch hysteresis", "[vt]")
 {
   auto split_method
     = GENERATE( bvh::split_algorithm::geom_axis, bvh::split_algorithm::ml_geom_axis, bvh::split_algorithm::clustering );
+
+  bvh::collision_world world( 4 );
+
+  auto &obj = world.create_collision_object();
+  obj.set_patch_hysteresis( 0.5 );
+
+  auto rank = ::vt::theContext()->getNode();
+  auto elements = build_element_grid( 2, 3, 2, rank * 12 );
+  // Same elements moved rigidly, the patches are still good
+  auto moved_elements = build_element_grid( 2, 3, 2, rank * 12, 10.0 );
+  // Same elements spread out, the patch bounds grow too much
+  auto stretched_elements = build_element_grid( 2, 3, 2, rank * 12 );
+  auto stretch = []( bvh::m::vec3d _v ) {
+    _v *= 3.0;
+    return _v;
+  };
+  for ( std::size_t i = 0; i < stretched_elements.extent( 0 ); ++i )
+  {
+    auto v = stretched_elements( i ).vertices();
+    stretched_elements( i ).setVertices( stretch( v[0] ), stretch( v[1] ), stretch( v[2] ), stretch( v[3] ),
+                                         stretch( v[4] ), stretch( v[5] ), stretch( v[6] ), stretch( v[7] ) );
+  }
+
+  std::vector< bvh::patch<> > first_patches;
+
+  ::vt::runInEpochCollective( "collision_object.patch_hysteresis.init", [&]() {
+    obj.set_entity_data( elements, split_method );
+    REQUIRE( !obj.patch_assignment_kept() );
+    auto p = obj.local_patches();
+    first_patches.assign( p.begin(), p.end() );
+  } );
+
+  ::vt::runInEpochCollective( "collision_object.patch_hysteresis.moved", [&]() {
+    obj.set_entity_data( moved_elements, split_method );
+    REQUIRE( obj.patch_assignment_kept() );
+    REQUIRE( obj.patch_membership_changes().empty() );
+
+    auto p = obj.local_patches();
+    REQUIRE( p.size() == first_patches.size() );
+    for ( std::size_t i = 0; i < p.size(); ++i )
+    {
+      REQUIRE( p[i].global_id() == first_patches[i].global_id() );
+      REQUIRE( p[i].size() == first_patches[i].size() );
+    }
+  } );
+
+  ::vt::runInEpochCollective( "collision_object.patch_hysteresis.stretched", [&]() {
+    obj.set_entity_data( stretched_elements, split_method );
+    REQUIRE( !obj.patch_assignment_kept() );
+    for ( auto &&c : obj.patch_membership_changes() )
+    {
+      REQUIRE( c.element < stretched_elements.extent( 0 ) );
+      REQUIRE( c.from_patch != c.to_patch );
+    }
+  } );
+}
+
+TEST_CASE( "collision_object rebalance hot patches", "[vt]")
+{
+  auto split_method = GENERATE( bvh::split_algorithm::geom_axis, bvh::split_algorithm::clustering );
+  auto in_process = GENERATE( true, false );
+
+  bvh::world_config cfg;
+  cfg.in_process = in_process;
+  bvh::collision_world world( 4, cfg );
+
+  auto &obj = world.create_collision_object();
+  auto &obj2 = world.create_collision_object();
+  obj.set_patch_rebalance_threshold( 1.5 );
+
+  auto rank = ::vt::theContext()->getNode();
+  auto elements = build_element_grid( 4, 4, 4, rank * 64 );
+  // Only overlaps the corner of the grid, so a single patch of `obj` takes part in the narrowphase
+  auto corner = build_element_grid( 1, 1, 1, rank, 0.9 );
+  std::vector< std::size_t > first_sizes;
+
+  ::vt::runInEpochCollective( "collision_object.rebalance.hot", [&]() {
+    world.start_iteration();
+
+    obj.set_entity_data( elements, split_method );
+    obj.init_broadphase();
+    obj2.set_entity_data( corner, split_method );
+    obj2.init_broadphase();
+
+    world.set_narrowphase_functor< Element >( []( const bvh::broadphase_collision< Element > &,
+                                                  const bvh::broadphase_collision< Element > & ) {
+      return bvh::narrowphase_result_pair();
+    } );
+    obj.broadphase( obj2 );
+
+    world.finish_iteration();
+
+    for ( auto &&p : obj.local_patches() )
+      first_sizes.push_back( p.size() );
+  } );
+
+  ::vt::runInEpochCollective( "collision_object.rebalance.rebalanced", [&]() {
+    obj.set_entity_data( elements, split_method );
+    REQUIRE( !obj.patch_assignment_kept() );
+    REQUIRE( obj.overdecomposition_factor() == 4 );
+
+    // The hot patch was cut into smaller patches, the others merged, without changing the number of patches
+    auto p = obj.local_patches();
+    REQUIRE( p.size() == first_sizes.size() );
+    std::vector< std::size_t > sizes;
+    for ( auto &&patch : p )
+      sizes.push_back( patch.size() );
+    REQUIRE( sizes != first_sizes );
+    REQUIRE( std::accumulate( sizes.begin(), sizes.end(), std::size_t{ 0 } ) == elements.extent( 0 ) );
+  } );
+}
+
+TEST_CASE( "collision_object save and load state", "[vt]")
+{
+  auto split_method
+    = GENERATE( bvh::split_algorithm::geom_axis, bvh::split_algorithm::ml_geom_axis, bvh::split_algorithm::clustering );
+  bvh::collision_world world( 4 );
+
+  auto &obj = world.create_collision_object();
+  auto &restored = world.create_collision_object();
+
+  auto rank = ::vt::theContext()->getNode();
+  auto elements = build_element_grid( 2, 3, 2, rank * 12 );
+  const auto path = fmt::format( "collision_object_state.{}.bin", rank );
+
+  ::vt::runInEpochCollective( "collision_object.save_state", [&]() {
+    obj.set_entity_data( elements, split_method );
+    obj.save_state( path );
+  } );
+
+  ::vt::runInEpochCollective( "collision_object.load_state", [&]() {
+    restored.load_state( path );
+    restored.set_entity_data( elements, split_method );
+    REQUIRE( restored.patch_assignment_kept() );
+
+    auto expected = obj.local_patches();
+    auto p = restored.local_patches();
+    REQUIRE( p.size() == expected.size() );
+    for ( std::size_t i = 0; i < p.size(); ++i )
+    {
+      REQUIRE( p[i].global_id() == expected[i].global_id() );
+      REQUIRE( p[i].size() == expected[i].size() );
+    }
+
+    // The restored assignment is only kept once
+    restored.set_entity_data( elements, split_method );
+    REQUIRE( !restored.patch_assignment_kept() );
+  } );
+
+  // Mismatched or missing state is reported so the caller can cold start
+  bvh::collision_world other_world( 2 );
+  auto &other = other_world.create_collision_object();
+  REQUIRE_THROWS_AS( other.load_state( path ), bvh::state_file_exception );
+  REQUIRE_THROWS_AS( restored.load_state( path + ".missing" ), bvh::state_file_exception );
+
+  // Truncated and corrupt files are detected before anything is deserialized
+  std::string bytes;
+  {
+    std::ifstream in( path, std::ios::binary );
+    bytes.assign( std::istreambuf_iterator< char >( in ), std::istreambuf_iterator< char >() );
+  }
+  const auto bad_path = path + ".bad";
+  auto write_bad = [&bad_path]( const std::string &_bytes ) {
+    std::ofstream out( bad_path, std::ios::binary | std::ios::trunc );
+    out.write( _bytes.data(), static_cast< std::streamsize >( _bytes.size() ) );
+  };
+
+  write_bad( bytes.substr( 0, bytes.size() - 1 ) );
+  REQUIRE_THROWS_AS( restored.load_state( bad_path ), bvh::state_file_exception );
+  write_bad( bytes.substr( 0, 4 ) );
+  REQUIRE_THROWS_AS( restored.load_state( bad_path ), bvh::state_file_exception );
+  auto corrupt = bytes;
+  corrupt.back() ^= 0x5a;
+  write_bad( corrupt );
+  REQUIRE_THROWS_AS( restored.load_state( bad_path ), bvh::state_file_exception );
+
+  std::remove( bad_path.c_str() );
+  std::remove( path.c_str() );
+}
+
+TEST_CASE( "collision_object broadphase", "[vt]")
+{
+  auto split_method
+    = GENERATE( bvh::split_algorithm::geom_axis, bvh::split_algorithm::ml_geom_axis, bvh::split_algorithm::clustering,
+                bvh::split_algorithm::global_morton );
   bvh::collision_world world( 2 );
 
   auto &obj = world.create_collision_object();
@@ -274,6 +469,105 @@ TEST_CASE( "collision_object broadphase", "[vt]")
   } );
 }
 
+/// Axis aligned extent of a local patch, to compare the patches of different ranks
+struct patch_extent
+{
+  std::size_t rank = 0;
+  std::size_t index = 0;
+  double min[3] = {};
+  double max[3] = {};
+};
+
+template<>
+struct checkpoint::ByteCopyNonIntrusive< patch_extent >
+{
+  using isByteCopyable = std::true_type;
+};
+
+double
+overlap_volume( const patch_extent &_a, const patch_extent &_b )
+{
+  double ret = 1.0;
+  for ( int d = 0; d < 3; ++d )
+    ret *= std::max( 0.0, std::min( _a.max[d], _b.max[d] ) - std::max( _a.min[d], _b.min[d] ) );
+  return ret;
+}
+
+void
+verify_global_morton_coherence( const bvh::vt::reducable_vector< patch_extent > &_extents )
+{
+  const auto &extents = _extents.vec;
+  REQUIRE( extents.size() == 2 * static_cast< std::size_t >( ::vt::theContext()->getNumNodes() ) );
+
+  // Patches with the same local index cover the same part of the key space on every rank, so they overlap
+  // everywhere, and more than patches with different indices do
+  double same = 0.0;
+  double different = 0.0;
+  for ( auto &&a : extents )
+  {
+    for ( auto &&b : extents )
+    {
+      if ( a.rank == b.rank )
+        continue;
+
+      const double v = overlap_volume( a, b );
+      if ( a.index == b.index )
+      {
+        CHECK( v > 0.0 );
+        same += v;
+      } else {
+        different += v;
+      }
+    }
+  }
+  CHECK( same >= different );
+}
+
+TEST_CASE( "collision_object global morton coherence", "[vt]")
+{
+  const auto rank = static_cast< std::size_t >( ::vt::theContext()->getNode() );
+  const auto num_ranks = static_cast< std::size_t >( ::vt::theContext()->getNumNodes() );
+
+  bvh::collision_world world( 2 );
+  auto &obj = world.create_collision_object();
+
+  // Every rank holds a diagonal striping of the same 4x4x4 grid, so the elements of every rank span the whole grid
+  auto grid = build_element_grid( 4, 4, 4 );
+  std::vector< std::size_t > mine;
+  for ( std::size_t i = 0; i < grid.extent( 0 ); ++i )
+    if ( ( i % 4 + ( i / 4 ) % 4 + i / 16 ) % num_ranks == rank )
+      mine.push_back( i );
+  bvh::view< Element * > elements( "elements", mine.size() );
+  for ( std::size_t i = 0; i < mine.size(); ++i )
+    elements( i ) = grid( mine[i] );
+
+  bvh::vt::reducable_vector< patch_extent > extents;
+  ::vt::runInEpochCollective( "collision_object.global_morton_coherence", [&]() {
+    obj.set_entity_data( elements, bvh::split_algorithm::global_morton );
+
+    const auto local_patches = obj.local_patches();
+    REQUIRE( local_patches.size() == 2 );
+    for ( std::size_t p = 0; p < local_patches.size(); ++p )
+    {
+      const auto k = local_patches[p].kdop();
+      patch_extent e;
+      e.rank = rank;
+      e.index = p;
+      for ( int d = 0; d < 3; ++d )
+      {
+        e.min[d] = k.cardinal_min()[d];
+        e.max[d] = k.cardinal_max()[d];
+      }
+      extents.vec.push_back( e );
+    }
+  } );
+
+  ::vt::runInEpochCollective( "collision_object.global_morton_coherence.verify", [&]() {
+    auto r = ::vt::theCollective()->global();
+    r->reduce< verify_global_morton_coherence, ::vt::collective::PlusOp >( ::vt::Node{ 0 }, extents );
+  } );
+}
+
 TEST_CASE( "collision_object multiple broadphase", "[vt]")
 {
   auto split_method
@@ -363,6 +657,13 @@ void verify_single_narrowphase( const bvh::vt::reducable_vector< detailed_narrow
       res.patch_p, res.element_p, res.patch_q, res.element_q );
   }
 
+  // Every pair ran exactly once, no matter in which order the ghosts arrived
+  auto dup = std::adjacent_find( results.begin(), results.end(),
+                                 []( const detailed_narrowphase_result &_lhs, const detailed_narrowphase_result &_rhs ) {
+    return _lhs.element_p == _rhs.element_p && _lhs.element_q == _rhs.element_q;
+  } );
+  CHECK( dup == results.end() );
+
   CHECK( results.size() == static_cast< std::size_t >( 12 * ::vt::theContext()->getNumNodes() ) );
   for ( std::size_t i = 0; i < std::min( results.size(), ref_rhs_element_ids.size() ); ++i )
   {
@@ -370,39 +671,241 @@ void verify_single_narrowphase( const bvh::vt::reducable_vector< detailed_narrow
   }
 }
 
-TEST_CASE( "collision_object narrowphase", "[vt]")
+/// \brief Every element of `_b` against the single element of `_a`, the result of the single narrowphase cases
+template< typename T >
+bvh::narrowphase_result_pair
+single_narrowphase_pair( const bvh::broadphase_collision< T > &_a, const bvh::broadphase_collision< T > &_b )
 {
-  auto split_method
-    = GENERATE( bvh::split_algorithm::geom_axis, bvh::split_algorithm::ml_geom_axis, bvh::split_algorithm::clustering );
+  auto res = bvh::narrowphase_result_pair();
+  res.a = bvh::narrowphase_result( sizeof( detailed_narrowphase_result ));
+  res.b = bvh::narrowphase_result( sizeof( detailed_narrowphase_result ));
+  auto &resa = static_cast< bvh::typed_narrowphase_result< detailed_narrowphase_result > & >( res.a );
+
+  for ( auto &&e: _b.elements ) {
+    resa.emplace_back( detailed_narrowphase_result{ _a.meta.global_id(), _a.elements[0].global_id(),
+                                                    _b.meta.global_id(), e.global_id() } );
+  }
 
-  bvh::vt::debug("{}: split method: {}\n", ::vt::theContext()->getNode(), static_cast< int >( split_method ) );
+  return res;
+}
 
-  bvh::collision_world world( 2 );
+/// \brief Set the data of an object to an element grid, see `run_single_narrowphase`
+auto
+element_grid_data( bvh::split_algorithm _split_method )
+{
+  return [_split_method]( bvh::collision_object &_obj, int _x, int _y, int _z, std::size_t _base_index ) {
+    auto elements = build_element_grid( _x, _y, _z, _base_index );
+    _obj.set_entity_data( elements, _split_method );
+    return elements;
+  };
+}
 
-  auto &obj = world.create_collision_object();
-  auto &obj2 = world.create_collision_object();
+/// \brief Run an iteration of one element per rank against a 2x3x2 element grid per rank and verify the results
+///
+/// \param[in] _set_data  sets the data of an object to an `( x, y, z, base index )` grid and returns whatever has to
+///                       stay alive until the narrowphase finished
+/// \param[in] _run       sets the narrowphase functor and runs the broadphase. Results it streams are appended to its
+///                       argument, the others are collected with `for_each_result`
+/// \return the results of this rank
+template< typename SetData, typename Run >
+std::vector< detailed_narrowphase_result >
+run_single_narrowphase( const std::string &_label, bvh::collision_world &_world, bvh::collision_object &_obj,
+                        bvh::collision_object &_obj2, SetData &&_set_data, Run &&_run )
+{
   bvh::vt::reducable_vector< detailed_narrowphase_result > results;
 
-  ::vt::runInEpochCollective( "collision_object.narrowphase", [&]() {
-    world.start_iteration();
+  ::vt::runInEpochCollective( _label, [&]() {
+    _world.start_iteration();
 
     auto rank = ::vt::theContext()->getNode();
 
-    auto elements = build_element_grid( 1, 1, 1, rank );
-    obj.set_entity_data( elements, split_method );
-    obj.init_broadphase();
+    auto data = _set_data( _obj, 1, 1, 1, rank );
+    _obj.init_broadphase();
 
-    auto elements2 = build_element_grid( 2, 3, 2, rank * 12 );
-    obj2.set_entity_data( elements2, split_method );
-    obj2.init_broadphase();
+    auto data2 = _set_data( _obj2, 2, 3, 2, rank * 12 );
+    _obj2.init_broadphase();
+
+    results.vec.clear();
+    _run( results.vec );
+
+    _obj.for_each_result< detailed_narrowphase_result >( [&]( const detailed_narrowphase_result &_res ) {
+      results.vec.emplace_back( _res );
+    } );
 
+    _world.finish_iteration();
+  } );
+
+  ::vt::runInEpochCollective( _label + ".verify", [&]() {
+    auto r = ::vt::theCollective()->global();
+    r->reduce< verify_single_narrowphase, ::vt::collective::PlusOp >( ::vt::Node{ 0 }, results );
+  } );
+
+  return results.vec;
+}
+
+TEST_CASE( "narrowphase patch delivered destinations", "[vt]")
+{
+  const auto nranks = ::vt::theContext()->getNumNodes();
+  bvh::collision_object_impl::narrowphase_patch_collection_type patch;
+  patch.set_generation( 1 );
+
+  // Several pairs on the same rank request the patch, only the first request sends it
+  for ( ::vt::NodeType r = 0; r < nranks; ++r )
+  {
+    CHECK( patch.mark_delivered( r ) );
+    CHECK( !patch.mark_delivered( r ) );
+    CHECK( !patch.mark_delivered( r ) );
+  }
+
+  // The same payload is not sent again, even if it is copied again in the same generation
+  patch.set_generation( 1 );
+  for ( ::vt::NodeType r = 0; r < nranks; ++r )
+    CHECK( !patch.mark_delivered( r ) );
+
+  // A new payload has to be delivered everywhere again
+  patch.set_generation( 2 );
+  for ( ::vt::NodeType r = 0; r < nranks; ++r )
+    CHECK( patch.mark_delivered( r ) );
+}
+
+TEST_CASE( "narrowphase_scheduler out of order payloads" )
+{
+  using scheduler_type = bvh::collision_world_impl::narrowphase_scheduler;
+  using key = scheduler_type::payload_key;
+
+  // Pairs of patches (object 0, patch i) with (object 1, patch j), where (0, 0) is local
+  const std::vector< std::pair< std::size_t, std::size_t > > pairs{ { 0, 0 }, { 0, 1 }, { 1, 0 }, { 1, 1 }, { 2, 1 } };
+  std::vector< key > arrivals{ { 0, 1 }, { 0, 2 }, { 1, 0 }, { 1, 1 } };
+
+  // Every order in which the ghosts can arrive
+  do
+  {
+    scheduler_type scheduler;
+    std::vector< int > runs( pairs.size(), 0 );
+
+    for ( std::size_t t = 0; t < pairs.size(); ++t )
+    {
+      std::vector< key > missing;
+      if ( pairs[t].first != 0 )
+        missing.push_back( { 0, pairs[t].first } );
+      missing.push_back( { 1, pairs[t].second } );
+      scheduler.add_task( bvh::span< const key >( missing.data(), missing.size() ), [&runs, t]() { ++runs[t]; } );
+    }
+    CHECK( scheduler.num_pending() == pairs.size() );
+
+    for ( auto &&k : arrivals )
+      scheduler.payload_ready( k );
+
+    CHECK( scheduler.num_pending() == 0 );
+    for ( auto &&r : runs )
+      CHECK( r == 1 );
+  } while ( std::next_permutation( arrivals.begin(), arrivals.end() ) );
+
+  // Tasks without missing payloads run right away
+  scheduler_type scheduler;
+  int runs = 0;
+  scheduler.add_task( {}, [&runs]() { ++runs; } );
+  CHECK( runs == 1 );
+  CHECK( scheduler.num_pending() == 0 );
+}
+
+TEST_CASE( "collision_object disjoint bounds", "[vt]")
+{
+  auto in_process = GENERATE( true, false );
+
+  bvh::world_config cfg;
+  cfg.in_process = in_process;
+  bvh::collision_world world( 2, cfg );
+
+  auto &obj = world.create_collision_object();
+  auto &obj2 = world.create_collision_object();
+  std::size_t num_calls = 0;
+  std::size_t num_results = 0;
+
+  // Whether any broadphase query of this rank found a pair for a local patch of `_obj`
+  auto any_local_pairs = []( const bvh::collision_object &_obj ) {
+    const auto &impl = _obj.get_impl();
+    return std::any_of( impl.patch_pair_counts.begin(), impl.patch_pair_counts.end(), []( std::size_t _c ) { return _c > 0; } )
+           || std::find( impl.active_narrowphase_local_index.begin(), impl.active_narrowphase_local_index.end(), true )
+                != impl.active_narrowphase_local_index.end();
+  };
+
+  auto run = [&]( const std::string &_label, double _shift ) {
+    ::vt::runInEpochCollective( _label, [&]() {
+      world.start_iteration();
+
+      auto rank = ::vt::theContext()->getNode();
+
+      auto elements = build_element_grid( 2, 3, 2, rank * 12 );
+      obj.set_entity_data( elements, bvh::split_algorithm::geom_axis );
+      obj.init_broadphase();
+
+      auto elements2 = build_element_grid( 1, 1, 1, rank, _shift );
+      obj2.set_entity_data( elements2, bvh::split_algorithm::geom_axis );
+      obj2.init_broadphase();
+
+      world.set_narrowphase_functor< Element >( [&num_calls]( const bvh::broadphase_collision< Element > &,
+                                                              const bvh::broadphase_collision< Element > & ) {
+        ++num_calls;
+        return bvh::narrowphase_result_pair();
+      } );
+
+      obj.broadphase( obj2 );
+
+      obj.for_each_result< detailed_narrowphase_result >( [&]( const detailed_narrowphase_result & ) { ++num_results; } );
+
+      world.finish_iteration();
+    } );
+  };
+
+  // Far away from the first object on every rank
+  run( "collision_object.disjoint_bounds", 100.0 );
+
+  // The pair was culled before the broadphase: no patch was queried and no narrowphase pair was inserted
+  REQUIRE( obj.get_impl().broadphase_culled );
+  REQUIRE( obj.get_impl().active_narrowphase_indices.empty() );
+  REQUIRE( !any_local_pairs( obj ) );
+  REQUIRE( !any_local_pairs( obj2 ) );
+  REQUIRE( num_calls == 0 );
+  REQUIRE( num_results == 0 );
+
+  // Overlapping objects of the same world go through the broadphase
+  run( "collision_object.disjoint_bounds.overlapping", 0.0 );
+  REQUIRE( !obj.get_impl().broadphase_culled );
+  REQUIRE( any_local_pairs( obj ) );
+}
+
+TEST_CASE( "collision_object narrowphase", "[vt]")
+{
+  auto split_method
+    = GENERATE( bvh::split_algorithm::geom_axis, bvh::split_algorithm::ml_geom_axis, bvh::split_algorithm::clustering,
+                bvh::split_algorithm::global_morton );
+
+  auto orientation = GENERATE( bvh::broadphase_orientation::this_patches, bvh::broadphase_orientation::other_patches,
+                               bvh::broadphase_orientation::automatic );
+
+  auto in_process = GENERATE( true, false );
+
+  auto parallel_broadphase = GENERATE( false, true );
+
+  bvh::vt::debug("{}: split method: {} orientation: {} in-process: {} parallel broadphase: {}\n", ::vt::theContext()->getNode(),
+                 static_cast< int >( split_method ), static_cast< int >( orientation ), in_process, parallel_broadphase );
+
+  bvh::world_config cfg;
+  cfg.in_process = in_process;
+  cfg.parallel_broadphase = parallel_broadphase;
+  bvh::collision_world world( 2, cfg );
+  REQUIRE( world.in_process() == ( in_process && ::vt::theContext()->getNumNodes() == 1 ) );
+
+  auto &obj = world.create_collision_object();
+  auto &obj2 = world.create_collision_object();
+
+  static_assert( std::is_default_constructible_v< detailed_narrowphase_result > );
+
+  run_single_narrowphase( "collision_object.narrowphase", world, obj, obj2, element_grid_data( split_method ),
+                          [&]( std::vector< detailed_narrowphase_result > & ) {
     world.set_narrowphase_functor< Element >( []( const bvh::broadphase_collision< Element > &_a,
                                                   const bvh::broadphase_collision< Element > &_b ) {
-      auto res = bvh::narrowphase_result_pair();
-      res.a = bvh::narrowphase_result( sizeof( detailed_narrowphase_result ));
-      res.b = bvh::narrowphase_result( sizeof( detailed_narrowphase_result ));
-      auto &resa = static_cast< bvh::typed_narrowphase_result< detailed_narrowphase_result > & >( res.a );
-
       REQUIRE( _a.object.id() == 0 );
       REQUIRE( _b.object.id() == 1 );
       // First patch only has one element, ever
@@ -412,16 +915,438 @@ TEST_CASE( "collision_object narrowphase", "[vt]")
       // Global id of the first patch should be the node from whence it came
       REQUIRE( _a.elements[0].global_id() < static_cast< std::size_t >( ::vt::theContext()->getNumNodes() ) );
 
-      for ( auto &&e: _b.elements ) {
+      for ( auto &&e: _b.elements )
+        REQUIRE( e.global_id() < static_cast< std::size_t >( ::vt::theContext()->getNumNodes() * 12 ) );
+
+      return single_narrowphase_pair( _a, _b );
+    } );
+
+    obj.broadphase( obj2, orientation );
+  } );
+}
+
+TEST_CASE( "collision_world create_collision_objects", "[vt]")
+{
+  auto in_process = GENERATE( true, false );
+
+  bvh::world_config cfg;
+  cfg.in_process = in_process;
+  bvh::collision_world world( 2, cfg );
+
+  auto &first = world.create_collision_object();
+  auto objs = world.create_collision_objects( 3 );
+  REQUIRE( objs.size() == 3 );
+  REQUIRE( world.num_collision_objects() == 4 );
+  REQUIRE( first.id() == 0 );
+  for ( std::size_t i = 0; i < objs.size(); ++i )
+    REQUIRE( objs[i].get().id() == i + 1 );
+
+  auto &obj = objs[0].get();
+  auto &obj2 = objs[1].get();
+
+  // The batch-created objects take part in the broadphase like individually created ones
+  run_single_narrowphase( "collision_world.create_collision_objects", world, obj, obj2,
+                          element_grid_data( bvh::split_algorithm::geom_axis ),
+                          [&]( std::vector< detailed_narrowphase_result > & ) {
+    world.set_narrowphase_functor< Element >( &single_narrowphase_pair< Element > );
+    obj.broadphase( obj2 );
+  } );
+}
+
+TEST_CASE( "collision_object parallel narrowphase", "[vt]")
+{
+  auto in_process = GENERATE( true, false );
+
+  bvh::world_config cfg;
+  cfg.in_process = in_process;
+  cfg.parallel_narrowphase = true;
+  bvh::collision_world world( 4, cfg );
+
+  auto &obj = world.create_collision_object();
+  auto &obj2 = world.create_collision_object();
+
+  run_single_narrowphase( "collision_object.parallel_narrowphase", world, obj, obj2,
+                          element_grid_data( bvh::split_algorithm::geom_axis ),
+                          [&]( std::vector< detailed_narrowphase_result > & ) {
+    // Called concurrently, so no assertions in there
+    world.set_narrowphase_functor< Element >( &single_narrowphase_pair< Element > );
+    obj.broadphase( obj2 );
+  } );
+}
+
+TEST_CASE( "collision_object compact split", "[vt]")
+{
+  auto split_method = GENERATE( bvh::split_algorithm::geom_axis, bvh::split_algorithm::clustering );
+  auto in_process = GENERATE( true, false );
+
+  bvh::world_config cfg;
+  cfg.in_process = in_process;
+  bvh::collision_world world( 4, cfg );
+
+  auto &obj = world.create_collision_object();
+  auto &obj2 = world.create_collision_object();
+  auto &full = world.create_collision_object();
+  obj.set_compact_split( true );
+  obj2.set_compact_split( true );
+  REQUIRE( obj2.compact_split() );
+  REQUIRE( !full.compact_split() );
+
+  run_single_narrowphase( "collision_object.compact_split", world, obj, obj2, element_grid_data( split_method ),
+                          [&]( std::vector< detailed_narrowphase_result > & ) {
+    world.set_narrowphase_functor< Element >( &single_narrowphase_pair< Element > );
+    obj.broadphase( obj2 );
+  } );
+
+  ::vt::runInEpochCollective( "collision_object.compact_split.assignment", [&]() {
+    // The grid coordinates and centroids are exact in float, so the compact split must match the full one
+    auto rank = ::vt::theContext()->getNode();
+    auto elements = build_element_grid( 4, 4, 4, rank * 64 );
+    obj2.set_entity_data( elements, split_method );
+    full.set_entity_data( elements, split_method );
+
+    auto compact_patches = obj2.local_patches();
+    auto full_patches = full.local_patches();
+    REQUIRE( compact_patches.size() == full_patches.size() );
+
+    std::size_t num_elements = 0;
+    for ( std::size_t i = 0; i < compact_patches.size(); ++i )
+    {
+      REQUIRE( compact_patches[i].size() == full_patches[i].size() );
+      REQUIRE( compact_patches[i].kdop() == full_patches[i].kdop() );
+      REQUIRE( compact_patches[i].centroid() == full_patches[i].centroid() );
+      num_elements += compact_patches[i].size();
+    }
+    REQUIRE( num_elements == elements.extent( 0 ) );
+  } );
+}
+
+/// Hexahedral mesh of the unit cube in structure-of-arrays form
+struct hex_mesh
+{
+  bvh::view< double *[3] > coordinates;
+  bvh::view< std::size_t *[8] > connectivity;
+  bvh::view< std::size_t * > global_ids;
+};
+
+hex_mesh
+build_hex_mesh( int _x, int _y, int _z, std::size_t _base_index )
+{
+  hex_mesh ret{ bvh::view< double *[3] >( "coordinates", ( _x + 1 ) * ( _y + 1 ) * ( _z + 1 ) ),
+                bvh::view< std::size_t *[8] >( "connectivity", _x * _y * _z ),
+                bvh::view< std::size_t * >( "global_ids", _x * _y * _z ) };
+
+  auto node = [&]( int _i, int _j, int _k ) {
+    return static_cast< std::size_t >( ( _k * ( _y + 1 ) + _j ) * ( _x + 1 ) + _i );
+  };
+
+  for ( int k = 0; k <= _z; ++k )
+    for ( int j = 0; j <= _y; ++j )
+      for ( int i = 0; i <= _x; ++i )
+      {
+        ret.coordinates( node( i, j, k ), 0 ) = static_cast< double >( i ) / _x;
+        ret.coordinates( node( i, j, k ), 1 ) = static_cast< double >( j ) / _y;
+        ret.coordinates( node( i, j, k ), 2 ) = static_cast< double >( k ) / _z;
+      }
+
+  std::size_t e = 0;
+  for ( int k = 0; k < _z; ++k )
+    for ( int j = 0; j < _y; ++j )
+      for ( int i = 0; i < _x; ++i, ++e )
+      {
+        const std::array< std::size_t, 8 > nodes{ node( i, j, k ), node( i + 1, j, k ), node( i + 1, j + 1, k ),
+                                                  node( i, j + 1, k ), node( i, j, k + 1 ), node( i + 1, j, k + 1 ),
+                                                  node( i + 1, j + 1, k + 1 ), node( i, j + 1, k + 1 ) };
+        for ( std::size_t n = 0; n < nodes.size(); ++n )
+          ret.connectivity( e, n ) = nodes[n];
+        ret.global_ids( e ) = _base_index + e;
+      }
+
+  return ret;
+}
+
+TEST_CASE( "collision_object coordinates and connectivity", "[vt]")
+{
+  using element_type = bvh::mesh_element< 8 >;
+
+  auto split_method
+    = GENERATE( bvh::split_algorithm::geom_axis, bvh::split_algorithm::ml_geom_axis, bvh::split_algorithm::clustering,
+                bvh::split_algorithm::global_morton );
+  auto in_process = GENERATE( true, false );
+
+  bvh::world_config cfg;
+  cfg.in_process = in_process;
+  bvh::collision_world world( 2, cfg );
+
+  auto &obj = world.create_collision_object();
+  auto &obj2 = world.create_collision_object();
+
+  run_single_narrowphase( "collision_object.coordinates_connectivity", world, obj, obj2,
+                          [&]( bvh::collision_object &_obj, int _x, int _y, int _z, std::size_t _base_index ) {
+    auto mesh = build_hex_mesh( _x, _y, _z, _base_index );
+    _obj.set_entity_data( mesh.coordinates, mesh.connectivity, mesh.global_ids, split_method );
+    return mesh;
+  }, [&]( std::vector< detailed_narrowphase_result > & ) {
+    world.set_narrowphase_functor< element_type >( []( const bvh::broadphase_collision< element_type > &_a,
+                                                       const bvh::broadphase_collision< element_type > &_b ) {
+      REQUIRE( _a.elements.size() == 1 );
+      // The gathered nodes span the unit cube
+      REQUIRE( _a.elements[0].vertices[0] == bvh::m::vec3d( 0.0, 0.0, 0.0 ) );
+      REQUIRE( _a.elements[0].vertices[6] == bvh::m::vec3d( 1.0, 1.0, 1.0 ) );
+
+      return single_narrowphase_pair( _a, _b );
+    } );
+
+    obj.broadphase( obj2 );
+  } );
+}
+
+TEST_CASE( "collision_object streaming results", "[vt]")
+{
+  auto split_method
+    = GENERATE( bvh::split_algorithm::geom_axis, bvh::split_algorithm::ml_geom_axis, bvh::split_algorithm::clustering );
+
+  bvh::collision_world world( 2 );
+
+  auto &obj = world.create_collision_object();
+  auto &obj2 = world.create_collision_object();
+  int num_done = 0;
+
+  run_single_narrowphase( "collision_object.streaming_results", world, obj, obj2, element_grid_data( split_method ),
+                          [&]( std::vector< detailed_narrowphase_result > &_results ) {
+    world.set_narrowphase_functor< Element >( &single_narrowphase_pair< Element > );
+
+    obj.stream_results< detailed_narrowphase_result >(
+      [&]( const detailed_narrowphase_result &_res ) {
+        // Nothing may arrive after the done notification
+        CHECK( num_done == 0 );
+        _results.emplace_back( _res );
+      },
+      [&]() { ++num_done; } );
+
+    obj.broadphase( obj2 );
+  } );
+
+  REQUIRE( num_done == 1 );
+}
+
+namespace
+{
+  /// Narrowphase payload that only carries the id of an \c Element
+  struct element_id
+  {
+    std::size_t id;
+
+    std::size_t global_id() const noexcept { return id; }
+  };
+}
+
+TEST_CASE( "collision_object narrowphase projection", "[vt]")
+{
+  auto split_method
+    = GENERATE( bvh::split_algorithm::geom_axis, bvh::split_algorithm::ml_geom_axis, bvh::split_algorithm::clustering );
+
+  bvh::collision_world world( 2 );
+
+  auto &obj = world.create_collision_object();
+  auto &obj2 = world.create_collision_object();
+
+  auto set_data = [split_method]( bvh::collision_object &_obj, int _x, int _y, int _z, std::size_t _base_index ) {
+    auto elements = build_element_grid( _x, _y, _z, _base_index );
+    _obj.set_entity_data( elements, split_method, []( const Element &_e ) { return element_id{ _e.global_id() }; } );
+    return elements;
+  };
+
+  run_single_narrowphase( "collision_object.narrowphase_projection", world, obj, obj2, set_data,
+                          [&]( std::vector< detailed_narrowphase_result > & ) {
+    world.set_narrowphase_functor< element_id >( []( const bvh::broadphase_collision< element_id > &_a,
+                                                     const bvh::broadphase_collision< element_id > &_b ) {
+      REQUIRE( _a.elements.size() == 1 );
+      REQUIRE( _a.elements[0].global_id() < static_cast< std::size_t >( ::vt::theContext()->getNumNodes() ) );
+
+      for ( auto &&e: _b.elements )
         REQUIRE( e.global_id() < static_cast< std::size_t >( ::vt::theContext()->getNumNodes() * 12 ) );
-        resa.emplace_back( detailed_narrowphase_result{ _a.meta.global_id(), _a.elements[0].global_id(),
-                                                        _b.meta.global_id(), e.global_id() } );
+
+      return single_narrowphase_pair( _a, _b );
+    } );
+
+    obj.broadphase( obj2 );
+  } );
+}
+
+TEST_CASE( "collision_object capture projected element size", "[vt]")
+{
+  const auto rank = static_cast< std::uint32_t >( ::vt::theContext()->getNode() );
+
+  bvh::collision_world world( 2 );
+  auto &obj = world.create_collision_object();
+
+  auto elements = build_element_grid( 2, 2, 2, 8 * rank );
+  world.start_capture( "capture_projection_test" );
+  obj.set_entity_data( elements, bvh::split_algorithm::geom_axis,
+                       []( const Element &_e ) { return element_id{ _e.global_id() }; } );
+  world.stop_capture();
+
+  const auto path = bvh::capture_file_path( "capture_projection_test", rank );
+  bvh::capture_reader reader( path );
+  bvh::capture_event ev;
+  bool found = false;
+  while ( reader.next( ev ) )
+  {
+    if ( ev.kind != bvh::capture_record::set_entity_data )
+      continue;
+    found = true;
+    REQUIRE( ev.element_size == sizeof( element_id ) );
+    REQUIRE( ev.entities.size() == elements.extent( 0 ) );
+  }
+  REQUIRE( found );
+
+  std::remove( path.c_str() );
+}
+
+TEST_CASE( "collision_object narrowphase element trees", "[vt]")
+{
+  auto split_method
+    = GENERATE( bvh::split_algorithm::geom_axis, bvh::split_algorithm::ml_geom_axis, bvh::split_algorithm::clustering );
+
+  bvh::collision_world world( 2 );
+
+  auto &obj = world.create_collision_object();
+  auto &obj2 = world.create_collision_object();
+  obj.set_element_trees( true );
+  obj2.set_element_trees( true );
+
+  run_single_narrowphase( "collision_object.narrowphase_element_trees", world, obj, obj2, element_grid_data( split_method ),
+                          [&]( std::vector< detailed_narrowphase_result > & ) {
+    world.set_narrowphase_functor< Element >( []( const bvh::broadphase_collision< Element > &_a,
+                                                  const bvh::broadphase_collision< Element > &_b ) {
+      // Only called for patches with overlapping elements
+      REQUIRE( !_a.element_candidates.empty() );
+
+      // The candidates must be exactly the overlapping element pairs
+      std::size_t num_overlapping = 0;
+      for ( auto &&a: _a.elements )
+        for ( auto &&b: _b.elements )
+          num_overlapping += overlap( a.kdop(), b.kdop() ) ? 1 : 0;
+      REQUIRE( _a.element_candidates.size() == num_overlapping );
+
+      for ( auto &&[i, j]: _a.element_candidates ) {
+        REQUIRE( i < _a.elements.size() );
+        REQUIRE( j < _b.elements.size() );
+        REQUIRE( overlap( _a.elements[i].kdop(), _b.elements[j].kdop() ) );
       }
 
-      return res;
+      // Every element of the grid overlaps the single element, so no pair is culled
+      return single_narrowphase_pair( _a, _b );
     } );
 
     obj.broadphase( obj2 );
+  } );
+}
+
+namespace
+{
+  /// An \c Element of one of several bodies of a multi-body object
+  struct body_element : Element
+  {
+    std::size_t body = 0;
+
+    std::size_t body_id() const noexcept { return body; }
+  };
+
+  static_assert( bvh::has_body_id_v< body_element > );
+  static_assert( !bvh::has_body_id_v< Element > );
+
+  /// Two overlapping grids of 8 elements, every 4 consecutive elements form a body
+  bvh::view< body_element * >
+  build_multi_body_elements( std::size_t _base_index )
+  {
+    auto grid = build_element_grid( 2, 2, 2, _base_index );
+    auto shifted = build_element_grid( 2, 2, 2, _base_index + 8, 0.25 );
+
+    bvh::view< body_element * > ret( "body_elements", 16 );
+    for ( std::size_t i = 0; i < 16; ++i )
+    {
+      const auto &e = ( i < 8 ) ? grid( i ) : shifted( i - 8 );
+      ret( i ) = body_element{ e, e.global_id() / 4 };
+    }
+
+    return ret;
+  }
+
+  void verify_multi_body_narrowphase( const bvh::vt::reducable_vector< detailed_narrowphase_result > &_res )
+  {
+    auto results = _res.vec;
+    std::sort( results.begin(), results.end(),
+               []( const detailed_narrowphase_result &_lhs, const detailed_narrowphase_result &_rhs ) {
+      if ( _lhs.element_p != _rhs.element_p )
+        return _lhs.element_p < _rhs.element_p;
+
+      return _lhs.element_q < _rhs.element_q;
+    } );
+
+    // Every pair of elements is reported once
+    auto dup = std::adjacent_find( results.begin(), results.end(),
+                                   []( const detailed_narrowphase_result &_lhs, const detailed_narrowphase_result &_rhs ) {
+      return _lhs.element_p == _rhs.element_p && _lhs.element_q == _rhs.element_q;
+    } );
+    CHECK( dup == results.end() );
+
+    // Every rank has the same elements, so the expected pairs can be counted from the elements of one rank
+    auto elements = build_multi_body_elements( 0 );
+    const std::size_t n = 16 * ::vt::theContext()->getNumNodes();
+    std::size_t expected = 0;
+    for ( std::size_t g = 0; g < n; ++g )
+      for ( std::size_t h = g + 1; h < n; ++h )
+        if ( g / 4 != h / 4 && overlap( elements( g % 16 ).kdop(), elements( h % 16 ).kdop() ) )
+          ++expected;
+
+    CHECK( expected > 0 );
+    CHECK( results.size() == expected );
+  }
+}
+
+TEST_CASE( "collision_object multi-body self broadphase", "[vt]")
+{
+  auto in_process = GENERATE( true, false );
+
+  bvh::world_config cfg;
+  cfg.in_process = in_process;
+  bvh::collision_world world( 2, cfg );
+
+  auto &obj = world.create_collision_object();
+  bvh::vt::reducable_vector< detailed_narrowphase_result > results;
+
+  ::vt::runInEpochCollective( "collision_object.multi_body", [&]() {
+    world.start_iteration();
+
+    auto rank = ::vt::theContext()->getNode();
+
+    auto elements = build_multi_body_elements( rank * 16 );
+    obj.set_entity_data( elements, bvh::split_algorithm::geom_axis );
+    REQUIRE( obj.multi_body() );
+    obj.init_broadphase();
+
+    world.set_narrowphase_functor< body_element >( []( const bvh::broadphase_collision< body_element > &_a,
+                                                       const bvh::broadphase_collision< body_element > &_b ) {
+      auto res = bvh::narrowphase_result_pair();
+      res.a = bvh::narrowphase_result( sizeof( detailed_narrowphase_result ));
+      res.b = bvh::narrowphase_result( sizeof( detailed_narrowphase_result ));
+      auto &resa = static_cast< bvh::typed_narrowphase_result< detailed_narrowphase_result > & >( res.a );
+
+      REQUIRE( !_a.element_candidates.empty() );
+      for ( auto &&[i, j]: _a.element_candidates ) {
+        const auto &a = _a.elements[i];
+        const auto &b = _b.elements[j];
+        REQUIRE( a.body_id() != b.body_id() );
+        REQUIRE( overlap( a.kdop(), b.kdop() ) );
+        resa.emplace_back( detailed_narrowphase_result{ _a.meta.global_id(), std::min( a.global_id(), b.global_id() ),
+                                                        _b.meta.global_id(), std::max( a.global_id(), b.global_id() ) } );
+      }
+
+      return res;
+    } );
+
+    obj.broadphase( obj );
 
     results.vec.clear();
     obj.for_each_result< detailed_narrowphase_result >( [&]( const detailed_narrowphase_result &_res ) {
@@ -431,11 +1356,45 @@ TEST_CASE( "collision_object narrowphase", "[vt]")
     world.finish_iteration();
   } );
 
-  static_assert( std::is_default_constructible_v< detailed_narrowphase_result > );
-
-  ::vt::runInEpochCollective( "collision_object.narrowphase.verify", [&]() {
+  ::vt::runInEpochCollective( "collision_object.multi_body.verify", [&]() {
     auto r = ::vt::theCollective()->global();
-    r->reduce< verify_single_narrowphase, ::vt::collective::PlusOp >( ::vt::Node{ 0 }, results );
+    r->reduce< verify_multi_body_narrowphase, ::vt::collective::PlusOp >( ::vt::Node{ 0 }, results );
+  } );
+}
+
+TEST_CASE( "collision_object batched narrowphase", "[vt]")
+{
+  auto split_method
+    = GENERATE( bvh::split_algorithm::geom_axis, bvh::split_algorithm::ml_geom_axis, bvh::split_algorithm::clustering );
+
+  bvh::collision_world world( 2 );
+
+  auto &obj = world.create_collision_object();
+  auto &obj2 = world.create_collision_object();
+
+  run_single_narrowphase( "collision_object.batched_narrowphase", world, obj, obj2, element_grid_data( split_method ),
+                          [&]( std::vector< detailed_narrowphase_result > & ) {
+    world.set_narrowphase_batch_functor< Element >( []( const bvh::broadphase_collision< Element > &_a,
+                                                        bvh::span< const bvh::broadphase_collision< Element > > _partners ) {
+      auto res = bvh::narrowphase_batch_result();
+      res.primary = bvh::narrowphase_result( sizeof( detailed_narrowphase_result ) );
+      auto &resa = static_cast< bvh::typed_narrowphase_result< detailed_narrowphase_result > & >( res.primary );
+
+      REQUIRE( _a.object.id() == 0 );
+      REQUIRE( _a.elements.size() == 1 );
+      REQUIRE( !_partners.empty() );
+
+      for ( auto &&b: _partners ) {
+        REQUIRE( b.object.id() == 1 );
+        for ( auto &&e: b.elements )
+          resa.emplace_back( detailed_narrowphase_result{ _a.meta.global_id(), _a.elements[0].global_id(),
+                                                          b.meta.global_id(), e.global_id() } );
+      }
+
+      return res;
+    } );
+
+    obj.broadphase( obj2 );
   } );
 }
 
@@ -547,6 +1506,71 @@ TEST_CASE( "collision_object narrowphase multi-iteration", "[vt]")
   std::cout << "========== Done, ready for next gen!\n";
 }
 
+TEST_CASE( "collision_object adaptive overdecomposition", "[vt]")
+{
+  auto in_process = GENERATE( true, false );
+
+  bvh::world_config cfg;
+  cfg.in_process = in_process;
+  bvh::collision_world world( 2, cfg );
+
+  auto &obj = world.create_collision_object();
+  auto &obj2 = world.create_collision_object();
+  // Decide after every step, on any predicted gain
+  obj2.set_adaptive_overdecomposition( 1, 8, 1, 0.0 );
+
+  for ( std::size_t i = 0; i < 4; ++i )
+  {
+    bvh::vt::reducable_vector< detailed_narrowphase_result > results;
+
+    ::vt::runInEpochCollective( "collision_object.adaptive_overdecomposition", [&]() {
+      world.start_iteration();
+
+      auto rank = ::vt::theContext()->getNode();
+
+      auto elements = build_element_grid( 1, 1, 1, rank );
+      obj.set_entity_data( elements, bvh::split_algorithm::geom_axis );
+      obj.init_broadphase();
+
+      auto elements2 = build_element_grid( 2, 3, 2, rank * 12 );
+      obj2.set_entity_data( elements2, bvh::split_algorithm::geom_axis );
+      REQUIRE( obj2.overdecomposition_factor() >= 1 );
+      REQUIRE( obj2.overdecomposition_factor() <= 8 );
+      REQUIRE( obj2.local_patches().size() == static_cast< std::size_t >( obj2.overdecomposition_factor() ) );
+      obj2.init_broadphase();
+
+      world.set_narrowphase_functor< Element >( []( const bvh::broadphase_collision< Element > &_a,
+                                                    const bvh::broadphase_collision< Element > &_b ) {
+        auto res = bvh::narrowphase_result_pair();
+        res.a = bvh::narrowphase_result( sizeof( detailed_narrowphase_result ));
+        res.b = bvh::narrowphase_result( sizeof( detailed_narrowphase_result ));
+        auto &resa = static_cast< bvh::typed_narrowphase_result< detailed_narrowphase_result > & >( res.a );
+
+        for ( auto &&e: _b.elements ) {
+          resa.emplace_back( detailed_narrowphase_result{ _a.meta.global_id(), _a.elements[0].global_id(),
+                                                          _b.meta.global_id(), e.global_id() } );
+        }
+
+        return res;
+      } );
+
+      obj.broadphase( obj2 );
+
+      obj.for_each_result< detailed_narrowphase_result >( [&]( const detailed_narrowphase_result &_res ) {
+        results.vec.emplace_back( _res );
+      } );
+
+      world.finish_iteration();
+    } );
+
+    // The results must not depend on the factor
+    ::vt::runInEpochCollective( "collision_object.adaptive_overdecomposition.verify", [&]() {
+      auto r = ::vt::theCollective()->global();
+      r->reduce< verify_single_narrowphase, ::vt::collective::PlusOp >( ::vt::Node{ 0 }, results );
+    } );
+  }
+}
+
 TEST_CASE( "collision_object narrowphase no overlap multi-iteration", "[vt]")
 {
   auto split_method
@@ -71,3 +71,30 @@ TEST_CASE("snapshot", "[snapshot][kokkos]")
     }
   }
 }
+
+TEST_CASE("compact snapshot", "[snapshot][kokkos]")
+{
+  std::default_random_engine eng( 0 );
+  auto kdops = generate_random_kdops( eng, 1000, bvh::m::vec3d{ -100.0, -100.0, -100.0 },
+                                      bvh::m::vec3d{ 100.0, 100.0, 100.0 }, 5.0 );
+  auto snapshots = Kokkos::create_mirror_view_and_copy( bvh::host_execution_space{}, snapshots_from_kdops( kdops ) );
+
+  REQUIRE( 2 * sizeof( bvh::compact_entity_snapshot ) <= sizeof( bvh::entity_snapshot ) );
+
+  for ( std::size_t i = 0; i < snapshots.extent( 0 ); ++i )
+  {
+    const auto &snap = snapshots( i );
+    const auto compact = bvh::make_compact_snapshot( snap, i );
+    REQUIRE( compact.local_index() == i );
+
+    // Rounded outward, so the compact bounds contain the original ones
+    const auto k = compact.kdop();
+    for ( int a = 0; a < bvh::bphase_kdop::num_axis; ++a )
+    {
+      REQUIRE( k.extents[a].min <= snap.kdop().extents[a].min );
+      REQUIRE( k.extents[a].max >= snap.kdop().extents[a].max );
+    }
+    for ( int d = 0; d < 3; ++d )
+      REQUIRE( compact.centroid()[d] == Approx( snap.centroid()[d] ) );
+  }
+}